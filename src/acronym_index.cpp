@@ -0,0 +1,276 @@
+#include "acronym_index.h"
+#include "normalizer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <functional>
+#include <utility>
+
+// ============================================================================
+// Acronym Index
+// ============================================================================
+
+namespace {
+
+// Words initialisms commonly leave out, as "mm" for Might and Magic
+constexpr std::array<std::string_view, 9> StopWords =
+        {"a", "an", "and", "for", "in", "of", "on", "the", "to"};
+
+// One letter would match a fraction of every title
+constexpr size_t MinLength = 2;
+
+// A name is spelled four ways, told apart by these bits of the spelling
+// index
+constexpr size_t Spellings   = 4;
+constexpr size_t NoStopWords = 1;
+constexpr size_t RomanDigits = 2;
+
+[[nodiscard]] bool is_number(const std::string_view token)
+{
+	return std::ranges::all_of(token, [](const char c) {
+		return std::isdigit(static_cast<unsigned char>(c)) != 0;
+	});
+}
+
+[[nodiscard]] bool is_numeral(const std::string_view token)
+{
+	return is_number(token) || Normalizer::roman_value(token) != 0;
+}
+
+// What a word adds to spelling s of an acronym: nothing for a stop word
+// left out, a number whole, a roman numeral as written or as digits, and
+// the first letter of anything else
+[[nodiscard]] std::string_view spelled(const std::string_view token,
+                                       const size_t s)
+{
+	if ((s & NoStopWords) != 0 &&
+	    std::ranges::find(StopWords, token) != StopWords.end()) {
+		return {};
+	}
+	if (is_number(token)) {
+		return token;
+	}
+	if (Normalizer::roman_value(token) != 0) {
+		return ((s & RomanDigits) != 0) ? Normalizer::normalize(token)
+		                                : token;
+	}
+	return token.substr(0, 1);
+}
+
+// A name in full, without parenthesized notes such as "(PCjr)", and as
+// titles are usually referred to, without its subtitle
+struct NameForms {
+	std::string_view full = {};
+	std::string_view main = {};
+};
+
+[[nodiscard]] NameForms name_forms(const std::string_view name)
+{
+	const auto full   = name.substr(0, name.find('('));
+	const size_t stop = std::min(full.find(':'), full.find(" - "));
+	return {full, full.substr(0, stop)};
+}
+
+// Appends the parts of the words of name ending by end that spelling s
+// takes for acronym: numbers and numerals whole, and else the initial.
+// True if they spell all of it with at most a sequel number left over.
+[[nodiscard]] bool spells(const std::string_view name,
+                          const std::span<const std::string_view> words,
+                          const char* const end,
+                          const std::string_view acronym,
+                          const size_t s,
+                          std::vector<std::string_view>& pieces)
+{
+	size_t pos    = 0;
+	size_t count  = 0; // words of the name
+	size_t extra  = 0; // parts left once the acronym is spelled
+	bool numbered = false;
+
+	for (const auto token : words) {
+		if (token.data() + token.size() > end) {
+			break;
+		}
+		const auto offset = static_cast<size_t>(token.data() -
+		                                        name.data());
+		if (Normalizer::follows_apostrophe(name, offset)) {
+			continue;
+		}
+		++count;
+		numbered = is_numeral(token);
+
+		const auto piece = spelled(token, s);
+		if (piece.empty()) {
+			continue;
+		}
+		if (pos == acronym.size()) {
+			++extra;
+			continue;
+		}
+		if (!acronym.substr(pos).starts_with(piece)) {
+			return false;
+		}
+		pos += piece.size();
+		pieces.push_back(numbered ? token : token.substr(0, 1));
+	}
+	return pos == acronym.size() && count >= AcronymIndex::MinWords &&
+	       (extra == 0 || (extra == 1 && numbered));
+}
+
+// Appends the acronyms of one lowercase name: the first letter of each
+// word, and numbers whole. It is spelled with and without stop words,
+// and with roman numerals as written and as digits. A name ending in a
+// sequel number is also spelled without it, so "kq" finds the series.
+void add_acronyms(const std::string_view name, const uint32_t entry,
+                  std::vector<std::pair<std::string, uint32_t>>& acronyms)
+{
+	// Each spelling, and its length before the last word
+	std::array<std::string, Spellings> spellings = {};
+	std::array<size_t, Spellings> series_lengths = {};
+	size_t words                                 = 0;
+	bool numbered                                = false;
+
+	for (const auto token : Util::tokenize(name)) {
+		const auto pos = static_cast<size_t>(token.data() -
+		                                     name.data());
+		if (Normalizer::follows_apostrophe(name, pos)) {
+			continue;
+		}
+		++words;
+		numbered = is_numeral(token);
+
+		for (size_t s = 0; s < spellings.size(); ++s) {
+			const auto piece = spelled(token, s);
+			if (piece.empty()) {
+				continue;
+			}
+			series_lengths[s] = spellings[s].size();
+			spellings[s] += piece;
+		}
+	}
+
+	if (words < AcronymIndex::MinWords) {
+		return;
+	}
+	for (size_t s = 0; s < spellings.size(); ++s) {
+		if (numbered && series_lengths[s] >= MinLength) {
+			acronyms.emplace_back(
+			        spellings[s].substr(0, series_lengths[s]),
+			        entry);
+		}
+		if (spellings[s].size() >= MinLength) {
+			acronyms.emplace_back(std::move(spellings[s]), entry);
+		}
+	}
+}
+
+} // namespace
+
+AcronymIndex::AcronymIndex(const std::span<const Entry> entries)
+{
+	// Each name is taken in full and without its subtitle
+	std::vector<std::pair<std::string, uint32_t>> acronyms = {};
+	for (uint32_t e = 0; e < entries.size(); ++e) {
+		const std::string_view content = entries[e].lower_content;
+		for (const auto& range : entries[e].names) {
+			const auto name  = content.substr(range.begin,
+			                                  range.length);
+			const auto forms = name_forms(name);
+
+			add_acronyms(forms.full, e, acronyms);
+			if (forms.main.size() < forms.full.size()) {
+				add_acronyms(forms.main, e, acronyms);
+			}
+		}
+	}
+
+	std::ranges::sort(acronyms);
+	const auto repeats = std::ranges::unique(acronyms);
+	acronyms.erase(repeats.begin(), repeats.end());
+
+	// One row per distinct acronym, holding its entries in order
+	offsets_.push_back(0);
+	posting_starts_.push_back(0);
+	for (size_t i = 0; i < acronyms.size();) {
+		const auto& spelling = acronyms[i].first;
+		text_ += spelling;
+		offsets_.push_back(static_cast<uint32_t>(text_.size()));
+		while (i < acronyms.size() && acronyms[i].first == spelling) {
+			postings_.push_back(acronyms[i].second);
+			++i;
+		}
+		const auto end = static_cast<uint32_t>(postings_.size());
+		posting_starts_.push_back(end);
+	}
+
+	// At most half full, so probe sequences stay short
+	if (size() > 0) {
+		slots_.assign(std::bit_ceil(size() * 2), EmptySlot);
+		const std::hash<std::string_view> hash = {};
+		const size_t mask                      = slots_.size() - 1;
+		for (uint32_t id = 0; id < size(); ++id) {
+			size_t slot = hash(acronym(id)) & mask;
+			while (slots_[slot] != EmptySlot) {
+				slot = (slot + 1) & mask;
+			}
+			slots_[slot] = id;
+		}
+	}
+
+	text_.shrink_to_fit();
+	postings_.shrink_to_fit();
+}
+
+[[nodiscard]] std::string_view AcronymIndex::acronym(const uint32_t id) const
+{
+	return std::string_view(text_).substr(offsets_[id],
+	                                      offsets_[id + 1] - offsets_[id]);
+}
+
+[[nodiscard]] std::span<const uint32_t> AcronymIndex::find(
+        const std::string_view word) const
+{
+	if (slots_.empty()) {
+		return {};
+	}
+
+	const size_t mask = slots_.size() - 1;
+	for (size_t slot = std::hash<std::string_view>{}(word) & mask;
+	     slots_[slot] != EmptySlot;
+	     slot = (slot + 1) & mask) {
+		const uint32_t id = slots_[slot];
+		if (acronym(id) == word) {
+			return std::span(postings_).subspan(
+			        posting_starts_[id],
+			        posting_starts_[id + 1] - posting_starts_[id]);
+		}
+	}
+	return {};
+}
+
+[[nodiscard]] bool AcronymIndex::spell(
+        const std::string_view name,
+        const std::span<const std::string_view> words,
+        const std::string_view acronym,
+        std::vector<std::string_view>& pieces)
+{
+	const auto forms  = name_forms(name);
+	const size_t mark = pieces.size();
+	for (const auto form : {forms.full, forms.main}) {
+		const char* const end = form.data() + form.size();
+		for (size_t s = 0; s < Spellings; ++s) {
+			if (spells(name, words, end, acronym, s, pieces)) {
+				return true;
+			}
+			pieces.resize(mark);
+		}
+	}
+	return false;
+}
+
+[[nodiscard]] size_t AcronymIndex::size() const
+{
+	return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
@@ -0,0 +1,59 @@
+#ifndef ACRONYM_INDEX_H
+#define ACRONYM_INDEX_H
+
+#include "entry_t.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Acronym Index
+// ============================================================================
+
+// Initialisms of every title, alternate name, developer and publisher,
+// such as "kq5" for King's Quest V or "ssi" for Strategic Simulations,
+// Inc., mapped to the entries that carry them. Built once at load: the
+// acronyms are stored back to back in one string with their entries in
+// compressed rows, and an open-addressed hash table over their ids
+// resolves a query word in one probe sequence.
+class AcronymIndex {
+	static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+	std::string text_                     = {};
+	std::vector<uint32_t> offsets_        = {}; // acronym i ends at i + 1
+	std::vector<uint32_t> posting_starts_ = {}; // likewise for its entries
+	std::vector<uint32_t> postings_       = {};
+	std::vector<uint32_t> slots_          = {}; // acronym ids, 2^n of them
+
+	[[nodiscard]] std::string_view acronym(const uint32_t id) const;
+
+public:
+	// Names of fewer words spell nothing worth indexing
+	static constexpr size_t MinWords = 2;
+
+	AcronymIndex() = default;
+
+	explicit AcronymIndex(const std::span<const Entry> entries);
+
+	// Entries with the lowercase acronym, in index order
+	[[nodiscard]] std::span<const uint32_t> find(
+	        const std::string_view word) const;
+
+	// Appends to pieces where a lowercase name spells the acronym as the
+	// index spells it: the initials, numbers and numerals it takes, as
+	// views into words, the name's tokens. False, appending nothing, if
+	// the name doesn't spell it.
+	[[nodiscard]] static bool spell(
+	        const std::string_view name,
+	        const std::span<const std::string_view> words,
+	        const std::string_view acronym,
+	        std::vector<std::string_view>& pieces);
+
+	[[nodiscard]] size_t size() const;
+};
+
+#endif
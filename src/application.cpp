@@ -3,76 +3,199 @@
 #include "utilities.h"
 
 #include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 // ============================================================================
 // Application
 // ============================================================================
 
-void Application::io_worker(std::atomic<bool>& stop_flag)
+void Application::dispatch(Command& cmd)
 {
 	using namespace std::string_view_literals;
 
-	while (!stop_flag.load(std::memory_order_acquire) && running_) {
-		try {
-			const auto cmd = queue_.pop(Timing::IOSleep);
-			if (!cmd) {
-				continue;
+	const auto handle = [this](auto&& arg) {
+		using T = std::decay_t<decltype(arg)>;
+
+		if constexpr (std::is_same_v<T, RefreshDisplay>) {
+			// New results reset the view. Otherwise the current
+			// view stays: the payload may be a search's stale
+			// default or a resize's older copy of it.
+			if (engine_.acquire_results()) {
+				state_.scroll_offset  = 0;
+				state_.selected_index = -1;
+			}
+			state_.metrics.dirty = true;
+			request_frame();
+			run_deferred_select();
+		} else if constexpr (std::is_same_v<T, UpdateQuery>) {
+			// Searches are dispatched when the debounce timer
+			// fires, so a burst runs only once. The header and its
+			// completions come from the vocabulary and are drawn
+			// right away.
+			search_due_ = std::chrono::steady_clock::now() +
+			              Timing::SearchDebounce;
+			schedule_timer();
+			request_frame();
+		} else if constexpr (std::is_same_v<T, MoveSelection>) {
+			handle_move(arg.delta);
+		} else if constexpr (std::is_same_v<T, PageScroll>) {
+			handle_page_scroll(arg.up);
+		} else if constexpr (std::is_same_v<T, SelectResult>) {
+			// Enter typed ahead of a search applies to the results
+			// of the query as typed
+			if (!results_match_query()) {
+				deferred_select_ = arg.index;
+			} else {
+				handle_select(arg.index);
 			}
+		} else if constexpr (std::is_same_v<T, Exit>) {
+			exit_code_ = arg.code;
+			running_   = false;
+		}
+	};
 
-			std::visit(
-			        [this](auto&& arg) {
-				        using T = std::decay_t<decltype(arg)>;
-
-				        try {
-					        if constexpr (std::is_same_v<T, RefreshDisplay>) {
-						        state_.scroll_offset =
-						                arg.state.scroll_offset;
-						        state_.selected_index =
-						                arg.state.selected_index;
-						        state_.metrics.dirty = true;
-						        state_.metrics = display_.render(
-						                state_);
-					        } else if constexpr (std::is_same_v<T, UpdateQuery>) {
-						        query_ = std::move(arg.query);
-						        engine_.update_query(query_);
-					        } else if constexpr (std::is_same_v<T, MoveSelection>) {
-						        handle_move(arg.delta);
-					        } else if constexpr (std::is_same_v<T, PageScroll>) {
-						        handle_page_scroll(arg.up);
-					        } else if constexpr (std::is_same_v<T, SelectResult>) {
-						        handle_select(arg.index);
-					        } else if constexpr (std::is_same_v<T, Exit>) {
-						        exit_code_ = arg.code;
-						        running_   = false;
-					        }
-				        } catch (const std::exception& e) {
-					        std::cerr << "Command error: "sv
-					                  << e.what() << '\n';
-				        } catch (...) {
-					        std::cerr << "Unknown command error\n"sv;
-				        }
-			        },
-			        *cmd);
-		} catch (const std::exception& e) {
-			std::cerr << "IO worker error: "sv << e.what() << '\n';
-		} catch (...) {
-			std::cerr << "Unknown IO worker error\n"sv;
+	try {
+		std::visit(handle, cmd);
+	} catch (const std::exception& e) {
+		std::cerr << "Command error: "sv << e.what() << '\n';
+	} catch (...) {
+		std::cerr << "Unknown command error\n"sv;
+	}
+}
+
+void Application::process_commands()
+{
+	while (running_) {
+		auto cmd = queue_.try_pop();
+		if (!cmd) {
+			break;
 		}
+		dispatch(*cmd);
 	}
 }
 
-void Application::handle_move(const int delta)
+void Application::read_input()
 {
-	const auto results = engine_.get_results();
-	if (results.empty()) {
+	input_.poll(query_, engine_, queue_);
+	arm_escape_timer();
+}
+
+void Application::arm_escape_timer()
+{
+	escape_due_.reset();
+	if (input_.awaiting_sequence()) {
+		escape_due_ = std::chrono::steady_clock::now() +
+		              Timing::EscapeTimeout;
+	}
+	schedule_timer();
+}
+
+void Application::run_due_timers()
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	if (search_due_ && *search_due_ <= now) {
+		search_due_.reset();
+		engine_.update_query(query_);
+	}
+	if (escape_due_ && *escape_due_ <= now) {
+		escape_due_.reset();
+		input_.expire(query_, engine_, queue_);
+	}
+	if (render_due_ && *render_due_ <= now) {
+		// present_frame() renders it once the commands are in
+		render_due_.reset();
+	}
+	schedule_timer();
+}
+
+void Application::schedule_timer()
+{
+	Deadline next = {};
+	for (const auto& due : {search_due_, escape_due_, render_due_}) {
+		if (due && (!next || *due < *next)) {
+			next = due;
+		}
+	}
+
+	if (!next) {
+		loop_.cancel_timer();
 		return;
 	}
+	const auto delay = std::chrono::ceil<std::chrono::milliseconds>(
+	        *next - std::chrono::steady_clock::now());
+	loop_.arm_timer(std::max(delay, std::chrono::milliseconds(0)));
+}
 
-	const int result_count = static_cast<int>(results.size());
+void Application::request_frame()
+{
+	frame_pending_ = true;
+}
+
+void Application::present_frame()
+{
+	if (!frame_pending_ || !running_) {
+		return;
+	}
+
+	// Renders at most once per interval, always from the latest state. A
+	// request inside the interval is held until its end, so input shows
+	// within one frame.
+	const auto now = std::chrono::steady_clock::now();
+
+	// A terminal that hasn't drained the last frame gets no new one yet;
+	// the frame drawn once it has is the latest state
+	if (now >= next_frame_ && display_.congested()) {
+		next_frame_ = now + std::max(frame_interval_,
+		                             std::chrono::milliseconds(
+		                                     Timing::FrameInterval));
+	}
+
+	if (now < next_frame_) {
+		if (!render_due_) {
+			render_due_ = next_frame_;
+			schedule_timer();
+		}
+		return;
+	}
+
+	frame_pending_ = false;
+	render_due_.reset();
+	next_frame_    = now + frame_interval_;
+	state_.metrics = display_.render(state_, query_);
+}
+
+[[nodiscard]] bool Application::results_match_query() const
+{
+	// query_ is edited by the input handler ahead of its UpdateQuery
+	return !search_due_ && engine_.results_current(query_);
+}
+
+void Application::run_deferred_select()
+{
+	if (deferred_select_ && results_match_query()) {
+		const int index = *deferred_select_;
+		deferred_select_.reset();
+		handle_select(index);
+	}
+}
+
+void Application::handle_move(const int delta)
+{
+	const int result_count = static_cast<int>(engine_.result_count());
+	if (result_count == 0) {
+		return;
+	}
 
 	if (state_.selected_index < 0) {
-		state_.selected_index = 0;
+		// The first move selects the first row; merged repeats and
+		// End carry on from there
+		state_.selected_index = std::clamp(delta - 1,
+		                                   0,
+		                                   result_count - 1);
 	} else {
 		state_.selected_index = std::clamp(state_.selected_index + delta,
 		                                   0,
@@ -90,17 +213,16 @@ void Application::handle_move(const int delta)
 		}
 	}
 
-	state_.metrics = display_.render(state_);
+	request_frame();
 }
 
 void Application::handle_page_scroll(const bool up)
 {
-	const auto results = engine_.get_results();
-	if (results.empty()) {
+	const size_t result_count = engine_.result_count();
+	if (result_count == 0) {
 		return;
 	}
 
-	const size_t result_count = results.size();
 	const size_t max_visible  = state_.metrics.max_visible_results;
 
 	if (max_visible == 0) {
@@ -128,22 +250,22 @@ void Application::handle_page_scroll(const bool up)
 		state_.scroll_offset = selected - max_visible + 1;
 	}
 
-	state_.metrics = display_.render(state_);
+	request_frame();
 }
 
 void Application::handle_select(const int index)
 {
-	const auto results = engine_.get_results();
+	const size_t result_count = engine_.result_count();
 
 	int target_index = index;
 	if (target_index < 0) {
 		if (state_.selected_index >= 0) {
 			target_index = state_.selected_index;
-		} else if (results.size() == 1) {
+		} else if (result_count == 1) {
 			target_index = 0;
-		} else if (results.size() > 1) {
+		} else if (result_count > 1) {
 			state_.selected_index = 0;
-			state_.metrics        = display_.render(state_);
+			request_frame();
 			return;
 		}
 	}
@@ -154,11 +276,49 @@ void Application::handle_select(const int index)
 	}
 }
 
-Application::Application(std::vector<Entry> entries)
-        : engine_(std::move(entries)),
-          display_(engine_)
+namespace {
+
+// EDS_FRAME_MS sets the minimum time between frames; 0 turns pacing off
+[[nodiscard]] std::chrono::milliseconds frame_interval_from_env()
+{
+	const char* value = std::getenv("EDS_FRAME_MS");
+	if (!value || !*value) {
+		return Timing::FrameInterval;
+	}
+
+	unsigned ms          = 0;
+	const auto* end      = value + std::strlen(value);
+	const auto [ptr, ec] = std::from_chars(value, end, ms);
+	if (ec != std::errc() || ptr != end) {
+		return Timing::FrameInterval;
+	}
+	return std::chrono::milliseconds(ms);
+}
+
+// EDS_SYNONYMS names a file of synonym groups; without one, only the
+// built-in spellings are folded
+[[nodiscard]] Normalizer normalizer_from_env()
 {
-	engine_.set_queue(&queue_);
+	const char* path = std::getenv("EDS_SYNONYMS");
+	if (!path || !*path) {
+		return {};
+	}
+	return Normalizer::load(path).value_or(Normalizer{});
+}
+
+} // namespace
+
+Application::Application(std::vector<Entry> entries, TaskScheduler& scheduler)
+        : engine_(std::move(entries), scheduler, normalizer_from_env()),
+          display_(engine_),
+          frame_interval_(frame_interval_from_env())
+{
+	engine_.set_queue(&queue_, &loop_);
+}
+
+Application::~Application()
+{
+	engine_.stop();
 }
 
 [[nodiscard]] int Application::run()
@@ -166,50 +326,74 @@ Application::Application(std::vector<Entry> entries)
 	using namespace std::string_view_literals;
 
 	try {
-		Util::clear_screen();
+		// The first frame switches to the alternate screen and clears
+		// it
+		std::string typed = {};
+		display_.set_synchronized(
+		        Util::supports_synchronized_output(typed));
 		engine_.update_query("");
 
-		std::atomic<bool> stop_flag{false};
-
-		auto search_thread = engine_.start(stop_flag);
-
-		std::thread io_thread(
-		        [this, &stop_flag]() { io_worker(stop_flag); });
+		// Keys typed before the terminal answered the probe
+		input_.feed(typed, query_, engine_, queue_);
+		arm_escape_timer();
 
 		while (running_) {
 			try {
-				if (const auto cmd = input_.poll(query_, engine_)) {
-					queue_.emplace(*cmd);
+				const auto events = loop_.wait();
+
+				if (events.interrupt) {
+					queue_.emplace(Exit{ExitSuccess});
 				}
-				std::this_thread::sleep_for(Timing::IOSleep);
+				if (events.resize) {
+					// One size query per burst of
+					// SIGWINCH; the refresh below relays
+					// out and repaints
+					display_.resize(Util::terminal_size());
+					queue_.emplace(RefreshDisplay{
+					        {state_.scroll_offset,
+					         state_.selected_index,
+					         {}}});
+				}
+				if (events.input) {
+					read_input();
+				}
+				if (events.timer) {
+					run_due_timers();
+				}
+
+				process_commands();
+				present_frame();
 			} catch (const std::exception& e) {
-				std::cerr << "Input error: "sv << e.what() << '\n';
+				std::cerr << "Event loop error: "sv << e.what()
+				          << '\n';
 			} catch (...) {
-				std::cerr << "Unknown input error\n"sv;
+				std::cerr << "Unknown event loop error\n"sv;
 			}
 		}
 
-		queue_.shutdown();
-
-		// Signal the io_thread to stop
-		stop_flag.store(true, std::memory_order_release);
-
-		// Explicitly join threads before returning
-		if (io_thread.joinable()) {
-			io_thread.join();
-		}
-		if (search_thread.joinable()) {
-			search_thread.join();
-		}
+		engine_.stop();
+		display_.restore_terminal();
 
 		std::cout << "\n\nSearch "sv
 		          << (exit_code_ == ExitSuccess ? "terminated"sv : "completed"sv)
 		          << ".\n"sv;
+
+		if (std::getenv("EDS_STATS")) {
+			const auto& stats = display_.frame_stats();
+			std::cerr << "Frames: "sv << stats.frames
+			          << ", bytes: "sv << stats.total_bytes
+			          << ", last frame: "sv << stats.last_bytes
+			          << " bytes in "sv << stats.last_lines
+			          << " lines, degraded "sv << stats.degradations
+			          << " times\n"sv;
+		}
 		return exit_code_;
 	} catch (const std::exception& e) {
+		display_.restore_terminal();
 		std::cerr << "Fatal error: "sv << e.what() << '\n';
 		return ExitError;
 	} catch (...) {
+		display_.restore_terminal();
 		std::cerr << "Unknown fatal error\n"sv;
 		return ExitError;
 	}
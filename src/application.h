@@ -2,12 +2,15 @@
 #define APPLICATION_H
 
 #include "display_manager.h"
+#include "event_loop.h"
 #include "exit_codes_t.h"
 #include "input_handler.h"
 #include "safe_queue.h"
 #include "search_engine.h"
 
 #include <atomic>
+#include <chrono>
+#include <optional>
 #include <string>
 
 // ============================================================================
@@ -15,17 +18,51 @@
 // ============================================================================
 
 class Application {
+	using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
 	SearchEngine engine_;
 	DisplayManager display_;
 	InputHandler input_       = {};
 	SafeQueue<Command> queue_ = {};
+	EventLoop loop_           = {};
+
+	DisplayState state_                 = {};
+	std::string query_                  = {};
+	std::optional<int> deferred_select_ = {};
 
-	DisplayState state_ = {};
-	std::string query_  = {};
+	// Deadlines multiplexed onto the event loop's single timer
+	Deadline search_due_ = {}; // debounced search dispatch
+	Deadline escape_due_ = {}; // lone Esc vs. start of a sequence
+	Deadline render_due_ = {}; // held-back frame
+
+	// Frame pacing: changes only mark a frame pending, and it is drawn
+	// after the commands of a wakeup are processed
+	std::chrono::milliseconds frame_interval_         = {};
+	std::chrono::steady_clock::time_point next_frame_ = {};
+	bool frame_pending_                               = false;
 	std::atomic<bool> running_{true};
 	std::atomic<int> exit_code_{ExitSuccess};
 
-	void io_worker(std::atomic<bool>& stop_flag);
+	void dispatch(Command& cmd);
+
+	void process_commands();
+
+	void read_input();
+
+	// Expires a partial escape sequence if no more input completes it
+	void arm_escape_timer();
+
+	void run_due_timers();
+
+	void schedule_timer();
+
+	void request_frame();
+
+	void present_frame();
+
+	[[nodiscard]] bool results_match_query() const;
+
+	void run_deferred_select();
 
 	void handle_move(const int delta);
 
@@ -34,7 +71,10 @@ class Application {
 	void handle_select(const int index);
 
 public:
-	explicit Application(std::vector<Entry> entries);
+	Application(std::vector<Entry> entries, TaskScheduler& scheduler);
+
+	// Stops the search first; it still reports to queue_ and loop_
+	~Application();
 
 	[[nodiscard]] int run();
 };
@@ -1,16 +1,19 @@
 #ifndef COMMAND_T
 #define COMMAND_T
 
+#include "safe_queue.h"
+
 #include <cstddef>
-#include <string>
 #include <variant>
 
 namespace Display {
-constexpr size_t MaxResults        = 10000;
-constexpr size_t SeparatorLength   = 60;
-constexpr size_t MaxPreviewLength  = 80;
-constexpr size_t MinLinesPerResult = 3;
-constexpr size_t MinVisibleResults = 2;
+constexpr size_t MaxResults         = 10000;
+constexpr size_t SeparatorLength    = 60;
+constexpr size_t MaxPreviewLength   = 80;
+constexpr size_t MinPreviewLength   = 10;
+constexpr size_t MinLinesPerResult  = 3;
+constexpr size_t MinVisibleResults  = 2;
+constexpr size_t HighlightedResults = 256; // top rows that get match spans
 } // namespace Display
 
 struct DisplayMetrics {
@@ -24,18 +27,16 @@ struct DisplayMetrics {
 };
 
 struct DisplayState {
-	size_t scroll_offset        = 0;
-	int selected_index          = -1;
-	DisplayMetrics metrics      = {};
-	size_t last_terminal_height = 0;
+	size_t scroll_offset   = 0;
+	int selected_index     = -1;
+	DisplayMetrics metrics = {};
 };
 
 struct RefreshDisplay {
 	DisplayState state = {};
 };
-struct UpdateQuery {
-	std::string query = {};
-};
+// The input handler edits the query in place; this marks that it changed
+struct UpdateQuery {};
 struct MoveSelection {
 	int delta = {};
 };
@@ -52,4 +53,53 @@ struct Exit {
 using Command = std::variant<RefreshDisplay, UpdateQuery, MoveSelection,
                              PageScroll, SelectResult, Exit>;
 
+// Commands are served by lane so Enter and Esc never wait behind a backlog
+// of repaints on a slow terminal. Enter shares the lane of the moves typed
+// before it, which must reach the selection first.
+namespace Lane {
+constexpr size_t Control = 0; // Exit
+constexpr size_t Query   = 1; // UpdateQuery, MoveSelection, PageScroll,
+                              // SelectResult
+constexpr size_t Render  = 2; // RefreshDisplay
+constexpr size_t Count   = 3;
+} // namespace Lane
+
+template <>
+struct QueueTraits<Command> {
+	static constexpr size_t Lanes = Lane::Count;
+
+	[[nodiscard]] static constexpr size_t lane(const Command& cmd)
+	{
+		if (std::holds_alternative<Exit>(cmd)) {
+			return Lane::Control;
+		}
+		if (std::holds_alternative<RefreshDisplay>(cmd)) {
+			return Lane::Render;
+		}
+		return Lane::Query;
+	}
+
+	// A pending refresh is obsolete once a newer refresh or a new query is
+	// queued, and a pending query once a newer one is. Exit drops both.
+	[[nodiscard]] static constexpr bool supersedes(const Command& newer,
+	                                               const Command& older)
+	{
+		const bool older_refresh =
+		        std::holds_alternative<RefreshDisplay>(older);
+		const bool older_query =
+		        std::holds_alternative<UpdateQuery>(older);
+
+		if (std::holds_alternative<Exit>(newer)) {
+			return older_refresh || older_query;
+		}
+		if (std::holds_alternative<UpdateQuery>(newer)) {
+			return older_refresh || older_query;
+		}
+		if (std::holds_alternative<RefreshDisplay>(newer)) {
+			return older_refresh;
+		}
+		return false;
+	}
+};
+
 #endif
\ No newline at end of file
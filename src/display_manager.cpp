@@ -3,6 +3,11 @@
 #include "timing_t.h"
 #include "utilities.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
 // ============================================================================
 // ANSI Color Codes
 // ============================================================================
@@ -19,26 +24,49 @@ constexpr auto Green      = "\033[92m"sv;
 constexpr auto Yellow     = "\033[93m"sv;
 constexpr auto Gray       = "\033[90m"sv;
 constexpr auto SelectedBg = "\033[48;5;24m\033[97m"sv;
+constexpr auto Match      = "\033[1m\033[93m"sv;
 } // namespace Color
 
-// ============================================================================
-// Display Manager
-// ============================================================================
-
-[[nodiscard]] size_t DisplayManager::get_terminal_height_cached() const
+namespace {
+constexpr size_t CongestedBytes = 4096; // backlog that lowers fidelity
+constexpr size_t SmoothFrames   = 8;    // quick frames to raise it again
+constexpr size_t PreviewIndent  = 4;
+
+// Appends text with the spans of one field highlighted. Span offsets are
+// shifted into text and clipped at limit; base is the style restored
+// after each span.
+void append_highlighted(FrameBuffer& buf, const std::string_view text,
+                        const std::span<const MatchSpan> spans,
+                        const MatchField field, const size_t shift,
+                        const size_t limit, const std::string_view base)
 {
-	const auto now = std::chrono::steady_clock::now();
-	if (cached_height_ == 0 || (now - last_check_) > Timing::HeightCache) {
-		cached_height_ = Util::terminal_height();
-		last_check_    = now;
+	size_t pos = 0;
+	for (const auto& span : spans) {
+		if (span.field != field) {
+			continue;
+		}
+		const size_t begin = span.begin + shift;
+		const size_t end   = std::min(begin + span.length, limit);
+		if (begin < pos || begin >= end) {
+			continue;
+		}
+		buf << text.substr(pos, begin - pos) << Color::Match
+		    << text.substr(begin, end - begin) << Color::Reset << base;
+		pos = end;
 	}
-	return cached_height_;
+	buf << text.substr(pos);
 }
 
+} // namespace
+
+// ============================================================================
+// Display Manager
+// ============================================================================
+
 [[nodiscard]] DisplayMetrics DisplayManager::measure_display(
         const DisplayMetrics& old_metrics) const
 {
-	const size_t current_height = get_terminal_height_cached();
+	const size_t current_height = size_.rows;
 
 	// Reuse if unchanged
 	if (!old_metrics.dirty &&
@@ -77,47 +105,72 @@ constexpr auto SelectedBg = "\033[48;5;24m\033[97m"sv;
 		metrics.max_visible_results = Display::MinVisibleResults;
 	}
 
+	if (fidelity_ == Fidelity::Minimal) {
+		metrics.max_visible_results =
+		        std::max(Display::MinVisibleResults,
+		                 metrics.max_visible_results / 2);
+	}
 	return metrics;
 }
 
-void DisplayManager::render_header(std::ostringstream& buf, const std::string& query,
-                                   const std::vector<std::string>& completions) const
+void DisplayManager::render_header(FrameBuffer& buf,
+                                   const std::string_view query,
+                                   const Completions& completions) const
 {
 	using namespace std::string_view_literals;
 	buf << Color::Bold << Color::Cyan << "Search: "sv << Color::Reset
 	    << query << Color::Cyan << "_"sv << Color::Reset << '\n';
 
-	if (!completions.empty() && !query.empty()) {
-		if (const auto hint = engine_.get_completion()) {
-			const size_t last_space = query.find_last_of(" \t");
-			const std::string preview =
-			        (last_space == std::string::npos)
-			                ? *hint
-			                : (last_space + 1 < hint->length()
-			                           ? hint->substr(last_space + 1)
-			                           : "");
-
-			if (!preview.empty()) {
-				buf << Color::Dim << "Tab: "sv << Color::Reset
-				    << Color::Green << preview << Color::Reset;
-
-				if (completions.size() > 1) {
-					buf << Color::Dim << " "sv << Color::Reset
-					    << Color::Gray << "("sv
-					    << Color::Yellow << completions.size()
-					    << " completions)"sv;
+	if (!query.empty()) {
+		constexpr size_t TopCount = Vocabulary::TopCompletions;
+		std::array<std::string_view, TopCount> top = {};
+		const size_t top_count = engine_.top_completions(query, top);
+
+		// What Tab does next: extend to the shared prefix, or else
+		// start cycling from the most frequent completion or next word
+		const auto hint    = engine_.completion_word(query);
+		const auto preview = hint              ? *hint
+		                     : (top_count > 0) ? top[0]
+		                                       : std::string_view();
+		if (!preview.empty()) {
+			buf << Color::Dim << "Tab: "sv << Color::Reset
+			    << Color::Green << preview << Color::Reset;
+
+			// Alternatives: completions of the word, or after a
+			// blank the words that usually follow the last one
+			if (completions.count > 1 ||
+			    (completions.empty() && top_count > 1)) {
+				buf << Color::Dim << " "sv << Color::Reset
+				    << Color::Gray << "("sv;
+				if (completions.empty()) {
+					buf << "next: "sv;
+				} else {
+					buf << Color::Yellow
+					    << completions.count
+					    << " completions"sv
+					    << Color::Gray;
+					if (top_count > 0) {
+						buf << ": "sv;
+					}
 				}
-				buf << '\n';
+				for (size_t i = 0; i < top_count; ++i) {
+					buf << ((i == 0) ? ""sv : ", "sv)
+					    << top[i];
+				}
+				buf << ")"sv;
 			}
+			buf << '\n';
 		}
 	}
 
-	buf << Color::Reset << Color::Gray
-	    << std::string(Display::SeparatorLength, '=') << '\n';
+	buf << Color::Reset << Color::Gray;
+	buf.repeat('=', Display::SeparatorLength);
+	buf << Color::Reset << '\n';
 }
 
-void DisplayManager::render_result(std::ostringstream& buf, const SearchResult& result,
-                                   size_t display_index, bool selected) const
+void DisplayManager::render_result(FrameBuffer& buf, const SearchResult& result,
+                                   size_t display_index, bool selected,
+                                   const std::span<const MatchSpan> spans) const
 {
 	using namespace std::string_view_literals;
 	if (result.index >= engine_.get_entry_count()) {
@@ -133,24 +186,67 @@ void DisplayManager::render_result(std::ostringstream& buf, const SearchResult&
 	buf << (selected ? '>' : ' ') << Color::Bold << "["sv
 	    << (display_index + 1) << "] "sv << Color::Reset;
 
-	if (selected) {
-		buf << Color::SelectedBg;
-	}
+	const auto base = selected ? Color::SelectedBg : std::string_view();
+	buf << base;
+
+	append_highlighted(buf,
+	                   entry.key,
+	                   spans,
+	                   MatchField::Key,
+	                   0,
+	                   entry.key.size(),
+	                   base);
+	buf << Color::Dim << " (score: "sv << result.score << ")"sv
+	    << Color::Reset << '\n';
+
+	// Content spans past the preview's cut aren't shown
+	const auto preview   = preview_line(result.index);
+	const bool truncated = entry.content_width > preview_cut_;
+	const size_t shown   = preview.size() - (truncated ? 3 : 0);
+	append_highlighted(buf,
+	                   preview,
+	                   spans,
+	                   MatchField::Content,
+	                   PreviewIndent,
+	                   shown,
+	                   {});
+	buf << "\n\n"sv;
+}
 
-	buf << entry.key << Color::Dim << " (score: "sv << result.score << ")"sv
-	    << Color::Reset << "\n    "sv;
+[[nodiscard]] std::string_view DisplayManager::preview_line(
+        const size_t index) const
+{
+	using namespace std::string_view_literals;
 
-	if (entry.content.length() > Display::MaxPreviewLength) {
-		const size_t truncate_len = std::min(Display::MaxPreviewLength - 3,
-		                                     entry.content.length());
-		buf << entry.content.substr(0, truncate_len) << "..."sv;
-	} else {
-		buf << entry.content;
+	const size_t columns = preview_columns();
+	if (preview_cut_ != columns) {
+		previews_.assign(engine_.get_entry_count(), std::nullopt);
+		preview_cut_ = columns;
 	}
-	buf << "\n\n"sv;
+
+	auto& line = previews_[index];
+	if (!line) {
+		const auto& entry = engine_.get_entry(index);
+		const std::string_view content = entry.content;
+
+		line.emplace(PreviewIndent, ' ');
+		if (entry.content_width > columns) {
+			// The cut is looked up in the widths measured at load,
+			// so it never splits a cluster or overflows on wide
+			// text
+			const size_t cut = Unicode::fit(content,
+			                                entry.content_stops,
+			                                columns - 3);
+			line->append(content.substr(0, cut));
+			line->append("..."sv);
+		} else {
+			line->append(content);
+		}
+	}
+	return *line;
 }
 
-void DisplayManager::render_footer(std::ostringstream& buf, size_t scroll_offset,
+void DisplayManager::render_footer(FrameBuffer& buf, size_t scroll_offset,
                                    size_t display_count, size_t total_results) const
 {
 	using namespace std::string_view_literals;
@@ -158,61 +254,260 @@ void DisplayManager::render_footer(std::ostringstream& buf, size_t scroll_offset
 	    << Color::Bold << Color::Cyan << "Showing "sv << (scroll_offset + 1)
 	    << "-"sv << (scroll_offset + display_count) << " of "sv
 	    << total_results << " results"sv << Color::Reset << '\n'
-	    << Color::Dim << "↑/↓: Select | PgUp/PgDn: Scroll | Enter: Confirm | "
-	    << "Tab: Complete | Esc: Cancel"sv << Color::Reset << '\n';
+	    << Color::Dim << "↑/↓: Select | PgUp/PgDn: Scroll | "sv
+	    << "Enter: Confirm | Tab: Complete | Esc: Cancel"sv
+	    << Color::Reset << '\n';
 }
 
-DisplayManager::DisplayManager(const SearchEngine& engine) : engine_(engine) {}
+namespace {
 
-[[nodiscard]] DisplayMetrics DisplayManager::render(DisplayState& state) const
+// Appends a cursor move to the start of a 1-based row
+void append_row_start(FrameBuffer& out, const size_t row)
+{
+	using namespace std::string_view_literals;
+	out << "\033["sv << row << ";1H"sv;
+}
+
+// Offsets of the lines in frame; a trailing newline doesn't start one
+void split_lines(const std::string_view frame, const size_t max_rows,
+                 std::vector<FrameLine>& lines)
+{
+	lines.clear();
+	for (size_t pos = 0; pos < frame.size() && lines.size() < max_rows;) {
+		size_t end = frame.find('\n', pos);
+		if (end == std::string_view::npos) {
+			end = frame.size();
+		}
+		lines.push_back({pos, end - pos});
+		pos = end + 1;
+	}
+}
+
+} // namespace
+
+void DisplayManager::present(const size_t height)
+{
+	using namespace std::string_view_literals;
+
+	if (fidelity_ != Fidelity::Full) {
+		frame_.strip_sgr();
+	}
+
+	out_.clear();
+	if (synchronized_) {
+		// The terminal holds the frame back until it is complete
+		out_ << "\033[?2026h"sv;
+	}
+	const size_t prologue = out_.size();
+
+	if (!on_alternate_screen_) {
+		// Repaints stay out of the scrollback and the original screen
+		// comes back on exit
+		out_ << "\033[?1049h"sv;
+		on_alternate_screen_ = true;
+		full_repaint_        = true;
+	}
+	if (full_repaint_) {
+		// Autowrap stays off so a long line can't shift the rows below
+		out_ << "\033[?7l\033[2J"sv;
+		screen_lines_.clear();
+		full_repaint_ = false;
+	}
+
+	// An unknown height (not a terminal) doesn't clip
+	const size_t max_rows = (height > 0)
+	                              ? height
+	                              : std::numeric_limits<size_t>::max();
+	split_lines(frame_.view(), max_rows, frame_lines_);
+
+	const auto text = [](const FrameBuffer& buf, const FrameLine& line) {
+		return buf.view().substr(line.offset, line.length);
+	};
+
+	size_t rewritten = 0;
+	for (size_t row = 0; row < frame_lines_.size(); ++row) {
+		const auto line = text(frame_, frame_lines_[row]);
+
+		// Lines are written from a reset state and cleared to the end,
+		// so each one can be repainted on its own
+		if (row >= screen_lines_.size() ||
+		    text(screen_, screen_lines_[row]) != line) {
+			append_row_start(out_, row + 1);
+			out_ << Color::Reset << line << Color::Reset
+			     << "\033[K"sv;
+			++rewritten;
+		}
+	}
+
+	if (frame_lines_.size() < screen_lines_.size()) {
+		append_row_start(out_, frame_lines_.size() + 1);
+		out_ << "\033[J"sv;
+	}
+
+	if (out_.size() > prologue) {
+		// Park the cursor below the frame, where it used to end up
+		append_row_start(out_, frame_lines_.size() + 1);
+		if (synchronized_) {
+			out_ << "\033[?2026l"sv;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		Util::write_stdout(out_.view());
+		adapt(std::chrono::steady_clock::now() - start);
+	} else {
+		out_.clear();
+	}
+
+	// The frame just shown becomes the one the next is diffed against
+	std::swap(frame_, screen_);
+	std::swap(frame_lines_, screen_lines_);
+
+	++stats_.frames;
+	stats_.last_bytes  = out_.size();
+	stats_.last_lines  = rewritten;
+	stats_.total_bytes += out_.size();
+}
+
+void DisplayManager::restore_terminal()
+{
+	using namespace std::string_view_literals;
+	if (on_alternate_screen_) {
+		Util::write_stdout("\033[?7h\033[?1049l"sv);
+		on_alternate_screen_ = false;
+	}
+}
+
+// A write that blocked or left a backlog steps fidelity down; a run of
+// frames that drained quickly steps it back up
+void DisplayManager::adapt(const std::chrono::steady_clock::duration write_time)
+{
+	backlog_ = Util::output_backlog();
+
+	const bool behind = write_time > Timing::SlowWrite ||
+	                    backlog_ > CongestedBytes;
+	if (behind) {
+		smooth_frames_ = 0;
+		if (fidelity_ != Fidelity::Minimal) {
+			fidelity_ = static_cast<Fidelity>(
+			        static_cast<uint8_t>(fidelity_) + 1);
+			++stats_.degradations;
+		}
+		return;
+	}
+
+	if (fidelity_ != Fidelity::Full && ++smooth_frames_ >= SmoothFrames) {
+		smooth_frames_ = 0;
+		fidelity_ = static_cast<Fidelity>(
+		        static_cast<uint8_t>(fidelity_) - 1);
+	}
+}
+
+[[nodiscard]] size_t DisplayManager::preview_columns() const
+{
+	const size_t longest = (fidelity_ == Fidelity::Full)
+	                             ? Display::MaxPreviewLength
+	                             : Display::MaxPreviewLength / 2;
+
+	// Narrow terminals cut previews at their right edge; an unknown
+	// width keeps the default
+	if (size_.cols == 0) {
+		return longest;
+	}
+	return std::clamp(size_.cols - std::min(size_.cols, PreviewIndent),
+	                  Display::MinPreviewLength,
+	                  longest);
+}
+
+[[nodiscard]] Fidelity DisplayManager::fidelity() const
+{
+	return fidelity_;
+}
+
+[[nodiscard]] bool DisplayManager::congested()
+{
+	// Only asks the terminal again while the last frame left a backlog
+	if (backlog_ > CongestedBytes) {
+		backlog_ = Util::output_backlog();
+	}
+	return backlog_ > CongestedBytes;
+}
+
+void DisplayManager::set_synchronized(const bool enabled)
+{
+	synchronized_ = enabled;
+}
+
+DisplayManager::DisplayManager(const SearchEngine& engine)
+        : engine_(engine),
+          size_(Util::terminal_size())
+{}
+
+DisplayManager::~DisplayManager()
+{
+	restore_terminal();
+}
+
+void DisplayManager::resize(const Util::TerminalSize& size)
+{
+	size_         = size;
+	full_repaint_ = true;
+}
+
+[[nodiscard]] const FrameStats& DisplayManager::frame_stats() const
+{
+	return stats_;
+}
+
+[[nodiscard]] DisplayMetrics DisplayManager::render(
+        DisplayState& state, const std::string_view query)
 {
 	using namespace std::string_view_literals;
 	try {
-		std::ostringstream buf;
-		buf << "\033[2J\033[H"sv; // Clear screen and home
+		auto& buf = frame_;
+		buf.clear();
 
-		const std::string query = engine_.get_query();
-		const auto results      = engine_.get_results();
-		const auto completions  = engine_.get_completions();
+		const size_t result_count = engine_.result_count();
+		const auto completions    = engine_.completions(query);
 
 		render_header(buf, query, completions);
 
-		DisplayMetrics metrics = measure_display(state.metrics);
-
-		// Detect terminal resize
-		const size_t current_height = get_terminal_height_cached();
-		if (state.last_terminal_height != current_height) {
-			state.last_terminal_height = current_height;
-			state.metrics.dirty        = true;
-			metrics = measure_display(state.metrics);
+		// Recomputed only when resize() changed the height or the
+		// fidelity changed
+		if (laid_out_for_ != fidelity_) {
+			laid_out_for_       = fidelity_;
+			state.metrics.dirty = true;
 		}
+		const DisplayMetrics metrics = measure_display(state.metrics);
 
-		if (results.empty()) {
+		if (result_count == 0) {
 			if (!query.empty()) {
 				buf << "No matches found.\n"sv;
 			}
-			std::cout << buf.str() << std::flush;
+			present(size_.rows);
 			return metrics;
 		}
 
-		const size_t display_count = std::min(metrics.max_visible_results,
-		                                      results.size() -
-		                                              state.scroll_offset);
-
-		for (size_t i = 0; i < display_count; ++i) {
-			const size_t idx = state.scroll_offset + i;
-			if (idx >= results.size()) {
-				break;
-			}
+		// Only the rows on screen are touched, however many matched
+		const auto visible =
+		        engine_.results(state.scroll_offset,
+		                        metrics.max_visible_results);
 
+		for (size_t i = 0; i < visible.size(); ++i) {
+			const size_t idx    = state.scroll_offset + i;
 			const bool selected = (static_cast<int>(idx) ==
 			                       state.selected_index);
-			render_result(buf, results[idx], idx, selected);
+			render_result(buf,
+			              visible[i],
+			              idx,
+			              selected,
+			              engine_.match_spans(idx));
 		}
 
-		render_footer(buf, state.scroll_offset, display_count, results.size());
+		render_footer(buf,
+		              state.scroll_offset,
+		              visible.size(),
+		              result_count);
 
-		std::cout << buf.str() << std::flush;
+		present(size_.rows);
 		return metrics;
 	} catch (const std::exception& e) {
 		std::cerr << "Display error: "sv << e.what() << '\n';
@@ -223,21 +518,22 @@ DisplayManager::DisplayManager(const SearchEngine& engine) : engine_(engine) {}
 	}
 }
 
-[[nodiscard]] std::optional<int> DisplayManager::select(const int index) const
+[[nodiscard]] std::optional<int> DisplayManager::select(const int index)
 {
 	using namespace std::string_view_literals;
 	try {
-		const auto results = engine_.get_results();
-		const auto i       = static_cast<size_t>(index);
-
-		if (index >= 0 && i < results.size() &&
-		    results[i].index < engine_.get_entry_count()) {
+		if (index < 0) {
+			return std::nullopt;
+		}
+		const auto row = engine_.results(static_cast<size_t>(index), 1);
 
-			const auto& entry = engine_.get_entry(results[i].index);
+		if (!row.empty() && row[0].index < engine_.get_entry_count()) {
+			const auto& entry = engine_.get_entry(row[0].index);
+			restore_terminal();
 			std::cout << "\n\nSelected: "sv << entry.key << '\n'
 			          << entry.content << '\n';
-			return std::min(static_cast<int>(results[i].index),
-			                MaxExitCode);
+			const int code = static_cast<int>(row[0].index);
+			return std::min(code, MaxExitCode);
 		}
 	} catch (const std::exception& e) {
 		std::cerr << "Selection error: "sv << e.what() << '\n';
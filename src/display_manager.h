@@ -1,41 +1,127 @@
 #ifndef DISPLAY_MANAGER_H
 #define DISPLAY_MANAGER_H
 
+#include "frame_buffer.h"
 #include "search_engine.h"
+#include "utilities.h"
 
 #include <chrono>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // ============================================================================
 // Display Manager
 // ============================================================================
 
+// Detail drawn, lowered while the terminal can't keep up with the output.
+// Reduced drops colours and halves previews; Minimal also halves the rows.
+enum class Fidelity : uint8_t { Full, Reduced, Minimal };
+
+struct FrameStats {
+	size_t frames       = 0;
+	size_t last_bytes   = 0; // written by the most recent frame
+	size_t last_lines   = 0; // lines rewritten by the most recent frame
+	size_t total_bytes  = 0;
+	size_t degradations = 0; // times fidelity was lowered
+};
+
+// A line of a composed frame, as a range of its buffer
+struct FrameLine {
+	size_t offset = 0;
+	size_t length = 0;
+};
+
 class DisplayManager {
 	const SearchEngine& engine_;
-	mutable size_t cached_height_                             = 0;
-	mutable std::chrono::steady_clock::time_point last_check_ = {};
 
-	[[nodiscard]] size_t get_terminal_height_cached() const;
+	// Only resize() changes this, so rendering never asks the terminal
+	Util::TerminalSize size_ = {};
+
+	// The frame being composed, the one on screen it is diffed against,
+	// and the escape sequences that turn one into the other. All keep
+	// their capacity, so steady-state frames don't allocate.
+	FrameBuffer frame_                   = {};
+	FrameBuffer screen_                  = {};
+	FrameBuffer out_                     = {};
+	std::vector<FrameLine> frame_lines_  = {};
+	std::vector<FrameLine> screen_lines_ = {};
+	bool full_repaint_                   = true;
+	bool on_alternate_screen_            = false;
+	bool synchronized_                   = false; // mode 2026 markers
+	FrameStats stats_                    = {};
+
+	// Output drain tracking, updated after every frame write
+	Fidelity fidelity_      = Fidelity::Full;
+	Fidelity laid_out_for_  = Fidelity::Full;
+	size_t backlog_         = 0; // terminal output queue after the write
+	size_t smooth_frames_   = 0; // consecutive frames that drained quickly
+
+	void adapt(const std::chrono::steady_clock::duration write_time);
+
+	// Display columns a preview may take at the current width and fidelity
+	[[nodiscard]] size_t preview_columns() const;
+
+	// Indented, truncated content lines of the entries that have been on
+	// screen, built the first time each is drawn. Entries never change,
+	// so a row costs a copy; a new preview width drops them all.
+	mutable std::vector<std::optional<std::string>> previews_ = {};
+	mutable size_t preview_cut_                               = 0;
+
+	[[nodiscard]] std::string_view preview_line(const size_t index) const;
 
 	[[nodiscard]] DisplayMetrics measure_display(const DisplayMetrics& old_metrics) const;
 
-	void render_header(std::ostringstream& buf, const std::string& query,
-	                   const std::vector<std::string>& completions) const;
+	void render_header(FrameBuffer& buf, const std::string_view query,
+	                   const Completions& completions) const;
 
-	void render_result(std::ostringstream& buf, const SearchResult& result,
-	                   size_t display_index, bool selected) const;
+	void render_result(FrameBuffer& buf, const SearchResult& result,
+	                   size_t display_index, bool selected,
+	                   const std::span<const MatchSpan> spans) const;
 
-	void render_footer(std::ostringstream& buf, size_t scroll_offset,
+	void render_footer(FrameBuffer& buf, size_t scroll_offset,
 	                   size_t display_count, size_t total_results) const;
 
+	// Writes the lines of frame_ that differ from the screen, at most
+	// height of them
+	void present(const size_t height);
+
 public:
 	explicit DisplayManager(const SearchEngine& engine);
 
-	[[nodiscard]] DisplayMetrics render(DisplayState& state) const;
+	~DisplayManager();
+
+	DisplayManager(const DisplayManager&)            = delete;
+	DisplayManager& operator=(const DisplayManager&) = delete;
+
+	// query is the one being typed, which the header shows even before
+	// the search for it has finished
+	[[nodiscard]] DisplayMetrics render(DisplayState& state,
+	                                    const std::string_view query);
+
+	// Takes the new size from a resize event; the next render lays the
+	// screen out again and repaints it
+	void resize(const Util::TerminalSize& size);
+
+	[[nodiscard]] const FrameStats& frame_stats() const;
+
+	[[nodiscard]] Fidelity fidelity() const;
+
+	// True while the terminal still has a large backlog; callers hold
+	// frames back until it drains
+	[[nodiscard]] bool congested();
+
+	// Leaves the alternate screen for the selection text
+	[[nodiscard]] std::optional<int> select(const int index);
+
+	// Wraps each frame in synchronized-output markers
+	void set_synchronized(const bool enabled);
 
-	[[nodiscard]] std::optional<int> select(const int index) const;
+	// Returns to the original screen; safe to call more than once
+	void restore_terminal();
 };
 
 #endif
\ No newline at end of file
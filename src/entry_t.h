@@ -1,14 +1,36 @@
 #ifndef ENTRY_T
 #define ENTRY_T
 
+#include "unicode.h"
+
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 
+// Where a title, alternate name, developer or publisher lies in content
+struct NameRange {
+	uint32_t begin  = 0;
+	uint32_t length = 0;
+};
+
 struct Entry {
 	std::string key                     = {};
 	std::string content                 = {};
-	std::vector<std::string_view> words = {};
+	std::string lower_key               = {};
+	std::string lower_content           = {};
+	std::vector<std::string_view> words = {}; // views into lower_content
+	size_t title_length                 = 0;  // title leads content
+	std::vector<NameRange> names        = {}; // title first
+
+	// The names in canonical spelling, as "kings quest 5" for "King's
+	// Quest V"; empty when that is how they are written
+	std::string canonical_content = {};
+
+	// Terminal columns of content and, unless it is plain ASCII, where
+	// its grapheme clusters end; measured once when the index is built
+	size_t content_width                            = 0;
+	std::vector<Unicode::ClusterStop> content_stops = {};
 };
 
 #endif
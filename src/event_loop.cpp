@@ -0,0 +1,411 @@
+#include "event_loop.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+#ifdef _WIN32
+#include <atomic>
+#include <conio.h>
+#elif defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// Event Loop
+// ============================================================================
+
+namespace {
+
+[[noreturn]] void throw_errno(const char* what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+#ifdef __linux__
+void close_fd(int& fd)
+{
+	if (fd >= 0) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+// Whether a descriptor epoll refused has nothing left to read: a regular
+// file read to its end, or anything else such as /dev/null
+[[nodiscard]] bool drained(const int fd)
+{
+	struct stat st = {};
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		return true;
+	}
+	const off_t offset = lseek(fd, 0, SEEK_CUR);
+	return offset < 0 || offset >= st.st_size;
+}
+#else
+// Milliseconds until the deadline, rounded up; -1 (infinite) when unset
+[[nodiscard]] int timeout_ms(
+        const std::optional<std::chrono::steady_clock::time_point>& deadline)
+{
+	if (!deadline) {
+		return -1;
+	}
+	const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+	        *deadline - std::chrono::steady_clock::now());
+	return static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+}
+#endif
+
+#ifdef _WIN32
+std::atomic<bool> interrupted{false};
+HANDLE interrupt_event = nullptr;
+
+BOOL WINAPI on_console_ctrl(DWORD)
+{
+	interrupted.store(true, std::memory_order_release);
+	SetEvent(interrupt_event);
+	return TRUE;
+}
+#elif !defined(__linux__)
+constexpr char WakeByte = 0; // no signal has number zero
+
+int signal_pipe = -1;
+
+void on_signal(const int signo)
+{
+	const int saved_errno = errno;
+	const char byte       = static_cast<char>(signo);
+	[[maybe_unused]] const auto n = write(signal_pipe, &byte, 1);
+	errno = saved_errno;
+}
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+EventLoop::EventLoop()
+        : input_(GetStdHandle(STD_INPUT_HANDLE)),
+          wake_(CreateEventW(nullptr, FALSE, FALSE, nullptr))
+{
+	if (!wake_) {
+		throw std::system_error(static_cast<int>(GetLastError()),
+		                        std::system_category(),
+		                        "CreateEvent");
+	}
+	interrupt_event = wake_;
+	SetConsoleCtrlHandler(on_console_ctrl, TRUE);
+}
+
+EventLoop::~EventLoop()
+{
+	SetConsoleCtrlHandler(on_console_ctrl, FALSE);
+	interrupt_event = nullptr;
+	CloseHandle(wake_);
+}
+
+[[nodiscard]] LoopEvents EventLoop::wait()
+{
+	LoopEvents events = {};
+
+	const std::array<HANDLE, 2> handles = {input_, wake_};
+	const int timeout = timeout_ms(deadline_);
+
+	const DWORD rc = WaitForMultipleObjects(
+	        static_cast<DWORD>(handles.size()),
+	        handles.data(),
+	        FALSE,
+	        timeout < 0 ? INFINITE : static_cast<DWORD>(timeout));
+
+	if (rc == WAIT_OBJECT_0) {
+		// The console handle is also signalled by focus, mouse and
+		// buffer-size records; drop those so the wait doesn't spin.
+		if (_kbhit()) {
+			events.input = true;
+		} else {
+			FlushConsoleInputBuffer(input_);
+			events.resize = true;
+		}
+	} else if (rc == WAIT_OBJECT_0 + 1) {
+		events.wake = true;
+		if (interrupted.exchange(false, std::memory_order_acq_rel)) {
+			events.interrupt = true;
+		}
+	}
+
+	if (deadline_ && std::chrono::steady_clock::now() >= *deadline_) {
+		deadline_.reset();
+		events.timer = true;
+	}
+	return events;
+}
+
+void EventLoop::notify()
+{
+	SetEvent(wake_);
+}
+
+#elif defined(__linux__)
+
+EventLoop::EventLoop()
+{
+	// Block the signals before any worker thread is started so they are
+	// only ever delivered through the signalfd
+	sigset_t mask = {};
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGWINCH);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &mask, &old_mask_);
+
+	epoll_fd_  = epoll_create1(EPOLL_CLOEXEC);
+	wake_fd_   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	timer_fd_  = timerfd_create(CLOCK_MONOTONIC,
+	                            TFD_NONBLOCK | TFD_CLOEXEC);
+
+	const auto fail = [this](const char* what) {
+		const int saved_errno = errno;
+		for (int* fd :
+		     {&epoll_fd_, &wake_fd_, &signal_fd_, &timer_fd_}) {
+			close_fd(*fd);
+		}
+		pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+		errno = saved_errno;
+		throw_errno(what);
+	};
+
+	if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0 || timer_fd_ < 0) {
+		fail("event loop setup");
+	}
+
+	for (const int fd : {STDIN_FILENO, wake_fd_, signal_fd_, timer_fd_}) {
+		epoll_event ev = {};
+		ev.events      = EPOLLIN;
+		ev.data.fd     = fd;
+		if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			// A file or /dev/null on stdin can't be polled; it is
+			// always readable, so wait() reports it itself
+			if (fd == STDIN_FILENO && errno == EPERM) {
+				stdin_file_ = true;
+				continue;
+			}
+			fail("epoll_ctl");
+		}
+	}
+}
+
+EventLoop::~EventLoop()
+{
+	for (int* fd : {&epoll_fd_, &wake_fd_, &signal_fd_, &timer_fd_}) {
+		close_fd(*fd);
+	}
+	pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+}
+
+[[nodiscard]] LoopEvents EventLoop::wait()
+{
+	LoopEvents events = {};
+
+	std::array<epoll_event, 4> ready = {};
+	const int n = epoll_wait(epoll_fd_,
+	                         ready.data(),
+	                         static_cast<int>(ready.size()),
+	                         stdin_file_ ? 0 : -1);
+	if (n < 0) {
+		if (errno == EINTR) {
+			return events;
+		}
+		throw_errno("epoll_wait");
+	}
+
+	for (const auto& ev : std::span(ready.data(), static_cast<size_t>(n))) {
+		if (ev.data.fd == STDIN_FILENO) {
+			if (ev.events & EPOLLIN) {
+				events.input = true;
+			} else if (ev.events & (EPOLLHUP | EPOLLERR)) {
+				events.interrupt = true;
+			}
+		} else if (ev.data.fd == wake_fd_) {
+			uint64_t count = 0;
+			[[maybe_unused]] const auto r = read(wake_fd_,
+			                                     &count,
+			                                     sizeof(count));
+			events.wake = true;
+		} else if (ev.data.fd == timer_fd_) {
+			uint64_t expirations = 0;
+			const auto size      = sizeof(expirations);
+			[[maybe_unused]] const auto r =
+			        read(timer_fd_, &expirations, size);
+			events.timer = true;
+		} else if (ev.data.fd == signal_fd_) {
+			signalfd_siginfo info = {};
+			while (read(signal_fd_, &info, sizeof(info)) ==
+			       static_cast<ssize_t>(sizeof(info))) {
+				if (info.ssi_signo == SIGWINCH) {
+					events.resize = true;
+				} else {
+					events.interrupt = true;
+				}
+			}
+		}
+	}
+
+	// Once read to the end, a file on stdin hangs up like a closed pipe
+	if (stdin_file_) {
+		if (drained(STDIN_FILENO)) {
+			events.interrupt = true;
+		} else {
+			events.input = true;
+		}
+	}
+	return events;
+}
+
+void EventLoop::notify()
+{
+	const uint64_t one = 1;
+	[[maybe_unused]] const auto r = write(wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::arm_timer(const std::chrono::milliseconds delay)
+{
+	using namespace std::chrono;
+
+	// An all-zero it_value disarms the timer, so round up to 1 ns
+	const auto ns      = std::max(duration_cast<nanoseconds>(delay), 1ns);
+	const auto seconds = duration_cast<std::chrono::seconds>(ns);
+
+	itimerspec spec       = {};
+	spec.it_value.tv_sec  = static_cast<time_t>(seconds.count());
+	spec.it_value.tv_nsec = static_cast<long>((ns - seconds).count());
+	timerfd_settime(timer_fd_, 0, &spec, nullptr);
+}
+
+void EventLoop::cancel_timer()
+{
+	const itimerspec spec = {};
+	timerfd_settime(timer_fd_, 0, &spec, nullptr);
+
+	// Discard an expiry that fired but hasn't been waited on yet
+	uint64_t expirations = 0;
+	[[maybe_unused]] const auto r = read(timer_fd_,
+	                                     &expirations,
+	                                     sizeof(expirations));
+}
+
+#else
+
+EventLoop::EventLoop()
+{
+	if (pipe(pipe_) < 0) {
+		throw_errno("pipe");
+	}
+	for (const int fd : pipe_) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+	signal_pipe = pipe_[1];
+
+	struct sigaction action = {};
+	action.sa_handler       = on_signal;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+
+	sigaction(SIGWINCH, &action, &old_winch_);
+	sigaction(SIGINT, &action, &old_int_);
+	sigaction(SIGTERM, &action, &old_term_);
+	sigaction(SIGHUP, &action, &old_hup_);
+	sigaction(SIGQUIT, &action, &old_quit_);
+}
+
+EventLoop::~EventLoop()
+{
+	sigaction(SIGWINCH, &old_winch_, nullptr);
+	sigaction(SIGINT, &old_int_, nullptr);
+	sigaction(SIGTERM, &old_term_, nullptr);
+	sigaction(SIGHUP, &old_hup_, nullptr);
+	sigaction(SIGQUIT, &old_quit_, nullptr);
+
+	signal_pipe = -1;
+	close(pipe_[0]);
+	close(pipe_[1]);
+}
+
+[[nodiscard]] LoopEvents EventLoop::wait()
+{
+	LoopEvents events = {};
+
+	std::array<pollfd, 2> fds = {
+	        pollfd{STDIN_FILENO, POLLIN, 0},
+	        pollfd{pipe_[0], POLLIN, 0},
+	};
+
+	const int n = poll(fds.data(), fds.size(), timeout_ms(deadline_));
+	if (n < 0 && errno != EINTR) {
+		throw_errno("poll");
+	}
+
+	if (n > 0) {
+		if (fds[0].revents & POLLIN) {
+			events.input = true;
+		} else if (fds[0].revents & (POLLHUP | POLLERR)) {
+			events.interrupt = true;
+		}
+
+		std::array<char, 64> buf = {};
+		ssize_t count            = 0;
+		while ((count = read(pipe_[0], buf.data(), buf.size())) > 0) {
+			for (ssize_t i = 0; i < count; ++i) {
+				const int signo = buf[static_cast<size_t>(i)];
+				if (signo == WakeByte) {
+					events.wake = true;
+				} else if (signo == SIGWINCH) {
+					events.resize = true;
+				} else {
+					events.interrupt = true;
+				}
+			}
+		}
+	}
+
+	if (deadline_ && std::chrono::steady_clock::now() >= *deadline_) {
+		deadline_.reset();
+		events.timer = true;
+	}
+	return events;
+}
+
+void EventLoop::notify()
+{
+	const char byte = WakeByte;
+	[[maybe_unused]] const auto n = write(pipe_[1], &byte, 1);
+}
+
+#endif
+
+#ifndef __linux__
+void EventLoop::arm_timer(const std::chrono::milliseconds delay)
+{
+	deadline_ = std::chrono::steady_clock::now() + delay;
+}
+
+void EventLoop::cancel_timer()
+{
+	deadline_.reset();
+}
+#endif
@@ -0,0 +1,73 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <chrono>
+#include <optional>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <signal.h>
+#endif
+
+// ============================================================================
+// Event Loop
+// ============================================================================
+
+struct LoopEvents {
+	bool input     = false; // stdin has bytes to read
+	bool wake      = false; // notify() was called from another thread
+	bool resize    = false; // terminal window changed size
+	bool interrupt = false; // SIGINT/TERM/HUP/QUIT or stdin hangup
+	bool timer     = false; // the armed deadline expired
+};
+
+// Single-threaded reactor the UI thread blocks in. On Linux it waits on
+// stdin, an eventfd, a signalfd and a timerfd with one epoll set; other
+// platforms fall back to poll() with a self-pipe, or to console handles.
+class EventLoop {
+#ifdef _WIN32
+	HANDLE input_ = nullptr;
+	HANDLE wake_  = nullptr;
+#elif defined(__linux__)
+	int epoll_fd_      = -1;
+	int wake_fd_       = -1;
+	int signal_fd_     = -1;
+	int timer_fd_      = -1;
+	sigset_t old_mask_ = {};
+	bool stdin_file_   = false; // can't be polled; always readable
+#else
+	int pipe_[2]                = {-1, -1};
+	struct sigaction old_winch_ = {};
+	struct sigaction old_int_   = {};
+	struct sigaction old_term_  = {};
+	struct sigaction old_hup_   = {};
+	struct sigaction old_quit_  = {};
+#endif
+
+#ifndef __linux__
+	std::optional<std::chrono::steady_clock::time_point> deadline_ = {};
+#endif
+
+public:
+	EventLoop();
+
+	~EventLoop();
+
+	EventLoop(const EventLoop&)            = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	// Blocks until at least one event source is ready
+	[[nodiscard]] LoopEvents wait();
+
+	// Thread-safe; wakes a blocked wait() with the wake event set
+	void notify();
+
+	// One-shot timer; re-arming replaces the previous deadline
+	void arm_timer(const std::chrono::milliseconds delay);
+
+	void cancel_timer();
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "frame_buffer.h"
+
+#include <array>
+#include <charconv>
+
+// ============================================================================
+// Frame Buffer
+// ============================================================================
+
+namespace {
+constexpr size_t MaxDigits = 24; // 64-bit values with sign
+} // namespace
+
+void FrameBuffer::append_unsigned(const unsigned long long value)
+{
+	std::array<char, MaxDigits> digits = {};
+	const auto [end, ec] = std::to_chars(digits.data(),
+	                                     digits.data() + digits.size(),
+	                                     value);
+	data_.append(digits.data(), end);
+}
+
+void FrameBuffer::append_signed(const long long value)
+{
+	std::array<char, MaxDigits> digits = {};
+	const auto [end, ec] = std::to_chars(digits.data(),
+	                                     digits.data() + digits.size(),
+	                                     value);
+	data_.append(digits.data(), end);
+}
+
+FrameBuffer::FrameBuffer() : FrameBuffer(DefaultCapacity) {}
+
+FrameBuffer::FrameBuffer(const size_t capacity)
+{
+	data_.reserve(capacity);
+}
+
+void FrameBuffer::clear()
+{
+	data_.clear();
+}
+
+void FrameBuffer::repeat(const char c, const size_t count)
+{
+	data_.append(count, c);
+}
+
+void FrameBuffer::strip_sgr()
+{
+	size_t out = 0;
+	for (size_t in = 0; in < data_.size();) {
+		if (data_[in] == '\033' && in + 1 < data_.size() &&
+		    data_[in + 1] == '[') {
+			size_t end = in + 2;
+			while (end < data_.size() &&
+			       ((data_[end] >= '0' && data_[end] <= '9') ||
+			        data_[end] == ';')) {
+				++end;
+			}
+			if (end < data_.size() && data_[end] == 'm') {
+				in = end + 1;
+				continue;
+			}
+		}
+		data_[out++] = data_[in++];
+	}
+	data_.resize(out);
+}
+
+[[nodiscard]] std::string_view FrameBuffer::view() const
+{
+	return data_;
+}
+
+[[nodiscard]] size_t FrameBuffer::size() const
+{
+	return data_.size();
+}
+
+[[nodiscard]] bool FrameBuffer::empty() const
+{
+	return data_.empty();
+}
+
+FrameBuffer& FrameBuffer::operator<<(const std::string_view text)
+{
+	data_.append(text);
+	return *this;
+}
+
+FrameBuffer& FrameBuffer::operator<<(const char c)
+{
+	data_.push_back(c);
+	return *this;
+}
@@ -0,0 +1,61 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ============================================================================
+// Frame Buffer
+// ============================================================================
+
+// Byte buffer a frame is composed in. It is reserved up front and clear()
+// keeps the capacity, so composing a frame doesn't allocate once the
+// buffer has seen the largest frame.
+class FrameBuffer {
+	std::string data_ = {};
+
+	void append_unsigned(const unsigned long long value);
+
+	void append_signed(const long long value);
+
+public:
+	static constexpr size_t DefaultCapacity = 64 * 1024;
+
+	FrameBuffer();
+
+	explicit FrameBuffer(const size_t capacity);
+
+	void clear();
+
+	void repeat(const char c, const size_t count);
+
+	// Removes colour and style (SGR) sequences in place
+	void strip_sgr();
+
+	[[nodiscard]] std::string_view view() const;
+
+	[[nodiscard]] size_t size() const;
+
+	[[nodiscard]] bool empty() const;
+
+	FrameBuffer& operator<<(const std::string_view text);
+
+	FrameBuffer& operator<<(const char c);
+
+	template <std::integral T>
+	        requires(!std::same_as<T, char> && !std::same_as<T, bool>)
+	FrameBuffer& operator<<(const T value)
+	{
+		if constexpr (std::is_signed_v<T>) {
+			append_signed(value);
+		} else {
+			append_unsigned(value);
+		}
+		return *this;
+	}
+};
+
+#endif
@@ -1,76 +1,230 @@
 #include "input_handler.h"
 #include "exit_codes_t.h"
-#include "timing_t.h"
+
+namespace {
+
+using namespace std::string_view_literals;
+
+constexpr auto EnablePaste  = "\033[?2004h"sv;
+constexpr auto DisablePaste = "\033[?2004l"sv;
+
+constexpr size_t ReadChunk = 4096;
+
+// Removes the last UTF-8 code point
+void erase_last_char(std::string& text)
+{
+	while (!text.empty()) {
+		const auto c = static_cast<unsigned char>(text.back());
+		text.pop_back();
+		if ((c & 0xC0) != 0x80) {
+			break;
+		}
+	}
+}
+
+// Removes trailing blanks and then the word before them
+void erase_last_word(std::string& text)
+{
+	while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+		text.pop_back();
+	}
+	const size_t last_space = text.find_last_of(" \t");
+	text.resize(last_space == std::string::npos ? 0 : last_space + 1);
+}
+
+// Start of the word being typed
+[[nodiscard]] size_t last_word_start(const std::string_view text)
+{
+	const size_t last_space = text.find_last_of(" \t");
+	return (last_space == std::string_view::npos) ? 0 : last_space + 1;
+}
+
+#ifdef _WIN32
+// _getch() reports navigation keys as a 0x00 or 0xE0 prefix plus a scan
+// code; map them to the VT sequences the decoder understands
+[[nodiscard]] std::string_view translate_scan_code(const int scan)
+{
+	switch (scan) {
+	case 71: return "\033[H"sv;
+	case 72: return "\033[A"sv;
+	case 73: return "\033[5~"sv;
+	case 79: return "\033[F"sv;
+	case 80: return "\033[B"sv;
+	case 81: return "\033[6~"sv;
+	case 83: return "\033[3~"sv;
+	default: return {};
+	}
+}
+#endif
+
+} // namespace
 
 // ============================================================================
 // Input Handler
 // ============================================================================
 
-[[nodiscard]] bool InputHandler::kbhit() const
+[[nodiscard]] size_t InputHandler::read_available(std::span<char> buffer) const
 {
 #ifdef _WIN32
-	return _kbhit() != 0;
+	constexpr size_t MaxSequence = 4;
+
+	size_t count = 0;
+	while (count + MaxSequence <= buffer.size() && _kbhit()) {
+		const int c = _getch();
+		if (c == 0x00 || c == 0xE0) {
+			const auto seq = translate_scan_code(_getch());
+			count += seq.copy(buffer.data() + count, seq.size());
+		} else {
+			buffer[count++] = static_cast<char>(c);
+		}
+	}
+	return count;
 #else
-	fd_set fds = {};
-	const timeval tv{0, 0};
-	FD_ZERO(&fds);
-	FD_SET(STDIN_FILENO, &fds);
-	return select(STDIN_FILENO + 1,
-	              &fds,
-	              nullptr,
-	              nullptr,
-	              const_cast<timeval*>(&tv)) > 0;
+	// VMIN and VTIME are zero, so read() returns what is buffered
+	const auto n = read(STDIN_FILENO, buffer.data(), buffer.size());
+	return (n > 0) ? static_cast<size_t>(n) : 0;
 #endif
 }
 
-[[nodiscard]] int InputHandler::getch() const
+void InputHandler::flush_moves(Batch& batch)
 {
-#ifdef _WIN32
-	return _getch();
-#else
-	char c = {};
-	return (read(STDIN_FILENO, &c, 1) > 0) ? c : -1;
-#endif
+	if (batch.move_delta != 0) {
+		batch.queue.emplace(MoveSelection{batch.move_delta});
+		batch.move_delta = 0;
+	}
 }
 
-void InputHandler::flush_input() const
+void InputHandler::finish(Batch& batch)
 {
-#ifdef _WIN32
-	while (_kbhit()) {
-		_getch();
+	flush_moves(batch);
+	if (batch.edited) {
+		batch.queue.emplace(UpdateQuery{});
+		batch.edited = false;
 	}
-#else
-	tcflush(STDIN_FILENO, TCIFLUSH);
-#endif
 }
 
-[[nodiscard]] int InputHandler::read_timeout(const int timeout_ms) const
+void InputHandler::handle_paste_key(const KeyEvent& event, Batch& batch)
 {
-#ifdef _WIN32
-	const auto start   = std::chrono::steady_clock::now();
-	const auto timeout = std::chrono::milliseconds(timeout_ms);
-	while (std::chrono::steady_clock::now() - start < timeout) {
-		if (_kbhit()) {
-			return _getch();
+	// Pasted text is one edit; line breaks and tabs become spaces so a
+	// pasted newline can't confirm a selection
+	switch (event.key) {
+	case Key::PasteEnd: in_paste_ = false; return;
+	case Key::Text: batch.query += event.byte; break;
+	case Key::Enter:
+	case Key::Tab: batch.query += ' '; break;
+	default: return;
+	}
+	batch.edited = true;
+}
+
+void InputHandler::handle_tab(const bool backwards, Batch& batch)
+{
+	auto& query       = batch.query;
+	const size_t word = last_word_start(query);
+
+	const bool cycling = cycle_count_ > 0 &&
+	                     std::string_view(query).substr(word) ==
+	                             cycle_[cycle_index_];
+	if (cycling) {
+		const size_t step = backwards ? cycle_count_ - 1 : 1;
+		cycle_index_      = (cycle_index_ + step) % cycle_count_;
+	} else if (batch.engine.complete_query(query)) {
+		cycle_count_ = 0;
+		batch.edited = true;
+		return;
+	} else {
+		cycle_count_ = batch.engine.top_completions(query, cycle_);
+		if (cycle_count_ == 0) {
+			return;
 		}
-		std::this_thread::sleep_for(Timing::IntraCharacterTimeout);
+		cycle_index_ = backwards ? cycle_count_ - 1 : 0;
 	}
-	return -1;
-#else
-	fd_set fds = {};
-	FD_ZERO(&fds);
-	FD_SET(STDIN_FILENO, &fds);
 
-	timeval tv{0, timeout_ms * 1000};
+	query.replace(word, std::string::npos, cycle_[cycle_index_]);
+	batch.edited = true;
+}
+
+void InputHandler::handle_key(const KeyEvent& event, Batch& batch)
+{
+	if (in_paste_) {
+		handle_paste_key(event, batch);
+		return;
+	}
+
+	const bool modified = (event.modifiers &
+	                       (Modifier::Shift | Modifier::Ctrl)) != 0;
+	const int page_jump = static_cast<int>(Display::MaxResults);
+
+	switch (event.key) {
+	case Key::Text:
+		batch.query += event.byte;
+		batch.edited = true;
+		break;
 
-	if (select(STDIN_FILENO + 1, &fds, nullptr, nullptr, &tv) > 0) {
-		char c = {};
-		if (read(STDIN_FILENO, &c, 1) == 1) {
-			return c;
+	case Key::Backspace:
+		if (!batch.query.empty()) {
+			erase_last_char(batch.query);
+			batch.edited = true;
 		}
+		break;
+
+	case Key::DeleteWord:
+		if (!batch.query.empty()) {
+			erase_last_word(batch.query);
+			batch.edited = true;
+		}
+		break;
+
+	case Key::ClearLine:
+		if (!batch.query.empty()) {
+			batch.query.clear();
+			batch.edited = true;
+		}
+		break;
+
+	case Key::Tab:
+	case Key::BackTab:
+		handle_tab(event.key == Key::BackTab, batch);
+		break;
+
+	case Key::Up:
+	case Key::Down:
+		if (modified) {
+			flush_moves(batch);
+			batch.queue.emplace(PageScroll{event.key == Key::Up});
+		} else {
+			batch.move_delta += (event.key == Key::Up) ? -1 : 1;
+		}
+		break;
+
+	case Key::PageUp:
+	case Key::PageDown:
+		flush_moves(batch);
+		batch.queue.emplace(PageScroll{event.key == Key::PageUp});
+		break;
+
+	case Key::Home:
+	case Key::End:
+		flush_moves(batch);
+		batch.queue.emplace(MoveSelection{
+		        event.key == Key::Home ? -page_jump : page_jump});
+		break;
+
+	case Key::Enter:
+		finish(batch);
+		batch.queue.emplace(SelectResult{-1});
+		break;
+
+	case Key::Escape:
+	case Key::Interrupt:
+		finish(batch);
+		batch.queue.emplace(Exit{ExitSuccess});
+		break;
+
+	case Key::PasteBegin: in_paste_ = true; break;
+
+	default: break;
 	}
-	return -1;
-#endif
 }
 
 InputHandler::InputHandler()
@@ -79,97 +233,69 @@ InputHandler::InputHandler()
 	tcgetattr(STDIN_FILENO, &old_term_);
 	termios new_term = old_term_;
 	new_term.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+	new_term.c_cc[VMIN]  = 0;
+	new_term.c_cc[VTIME] = 0;
 	tcsetattr(STDIN_FILENO, TCSANOW, &new_term);
+
+	[[maybe_unused]] const auto n = write(STDOUT_FILENO,
+	                                      EnablePaste.data(),
+	                                      EnablePaste.size());
 #endif
 }
 
 InputHandler::~InputHandler()
 {
 #ifndef _WIN32
+	[[maybe_unused]] const auto n = write(STDOUT_FILENO,
+	                                      DisablePaste.data(),
+	                                      DisablePaste.size());
 	tcsetattr(STDIN_FILENO, TCSANOW, &old_term_);
 #endif
 }
 
-[[nodiscard]] std::optional<Command> InputHandler::poll(std::string& query,
-                                                        const SearchEngine& engine)
+void InputHandler::poll(std::string& query, const SearchEngine& engine,
+                        SafeQueue<Command>& queue)
 {
-	if (!kbhit()) {
-		return std::nullopt;
-	}
+	std::array<char, ReadChunk> chunk = {};
+	Batch batch                       = {query, engine, queue};
 
-	const auto c = getch();
+	size_t count = 0;
+	do {
+		count = read_available(chunk);
+		decode(std::string_view(chunk.data(), count), batch);
+	} while (count == chunk.size());
 
-	if (c == 0x03) { // Ctrl+C
-		return Exit{ExitSuccess};
-	}
+	finish(batch);
+}
 
-	if (c == 0x09) { // Tab completion
-		if (auto comp = engine.get_completion()) {
-			query = *comp;
-			return UpdateQuery{query};
-		}
-		return std::nullopt;
-	}
+void InputHandler::feed(const std::string_view bytes, std::string& query,
+                        const SearchEngine& engine, SafeQueue<Command>& queue)
+{
+	Batch batch = {query, engine, queue};
+	decode(bytes, batch);
+	finish(batch);
+}
 
-	if (c == 127 || c == 8) { // Backspace
-		if (!query.empty()) {
-			query.pop_back();
-			return UpdateQuery{query};
+void InputHandler::decode(const std::string_view bytes, Batch& batch)
+{
+	for (const char byte : bytes) {
+		if (const auto event = decoder_.feed(byte)) {
+			handle_key(*event, batch);
 		}
-		return std::nullopt;
-	}
-
-	if (c == '\r' || c == '\n') { // Enter
-		return SelectResult{-1};
 	}
+}
 
-	if (c == 0x1B) { // Escape sequence
-		const int c1 = read_timeout(
-		        static_cast<int>(Timing::InputTimeout.count()));
-		if (c1 == -1) {
-			return Exit{ExitSuccess};
-		}
-		if (c1 != '[') {
-			flush_input();
-			return std::nullopt;
-		}
-
-		const int c2 = read_timeout(
-		        static_cast<int>(Timing::InputTimeout.count()));
-		if (c2 == -1) {
-			flush_input();
-			return std::nullopt;
-		}
-
-		switch (c2) {
-		case 'A': flush_input(); return MoveSelection{-1};
-		case 'B': flush_input(); return MoveSelection{1};
-		case '5': {
-			const int c3 = read_timeout(
-			        static_cast<int>(Timing::InputTimeout.count()));
-			if (c3 == '~') {
-				flush_input();
-				return PageScroll{true};
-			}
-			break;
-		}
-		case '6': {
-			const int c3 = read_timeout(
-			        static_cast<int>(Timing::InputTimeout.count()));
-			if (c3 == '~') {
-				flush_input();
-				return PageScroll{false};
-			}
-			break;
-		}
-		}
-		return std::nullopt;
-	}
+[[nodiscard]] bool InputHandler::awaiting_sequence() const
+{
+	return decoder_.pending();
+}
 
-	if (c >= 32 && c <= 126) { // Printable characters
-		query += static_cast<char>(c);
-		return UpdateQuery{query};
+void InputHandler::expire(std::string& query, const SearchEngine& engine,
+                          SafeQueue<Command>& queue)
+{
+	Batch batch = {query, engine, queue};
+	if (const auto event = decoder_.expire()) {
+		handle_key(*event, batch);
 	}
-
-	return std::nullopt;
+	finish(batch);
 }
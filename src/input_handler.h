@@ -1,10 +1,13 @@
 #ifndef INPUT_HANDLER_H
 #define INPUT_HANDLER_H
 
+#include "key_decoder.h"
 #include "search_engine.h"
 
-#include <optional>
+#include <array>
+#include <span>
 #include <string>
+#include <string_view>
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -25,14 +28,41 @@ class InputHandler {
 #ifndef _WIN32
 	termios old_term_ = {};
 #endif
+	KeyDecoder decoder_ = {};
+	bool in_paste_      = false;
 
-	[[nodiscard]] bool kbhit() const;
+	// Tab with nothing left to extend steps through the top completions
+	// of the word it started from, for as long as the query ends in the
+	// one it put there
+	std::array<std::string_view, Vocabulary::TopCompletions> cycle_ = {};
+	size_t cycle_count_                                            = 0;
+	size_t cycle_index_                                            = 0;
 
-	[[nodiscard]] int getch() const;
+	// State shared by the keys decoded from one read
+	struct Batch {
+		std::string& query;
+		const SearchEngine& engine;
+		SafeQueue<Command>& queue;
+		int move_delta = 0;
+		bool edited    = false;
+	};
 
-	void flush_input() const;
+	// Reads what is buffered without blocking; returns the byte count
+	[[nodiscard]] size_t read_available(std::span<char> buffer) const;
 
-	[[nodiscard]] int read_timeout(const int timeout_ms) const;
+	void decode(const std::string_view bytes, Batch& batch);
+
+	void handle_key(const KeyEvent& event, Batch& batch);
+
+	void handle_paste_key(const KeyEvent& event, Batch& batch);
+
+	void handle_tab(const bool backwards, Batch& batch);
+
+	// Queues the merged arrow-key movement so far, keeping it ordered
+	// before the command that follows it
+	static void flush_moves(Batch& batch);
+
+	static void finish(Batch& batch);
 
 public:
 	InputHandler();
@@ -42,8 +72,23 @@ public:
 	InputHandler(const InputHandler&)            = delete;
 	InputHandler& operator=(const InputHandler&) = delete;
 
-	[[nodiscard]] std::optional<Command> poll(std::string& query,
-	                                          const SearchEngine& engine);
+	// Decodes all pending input into commands. Query edits in the batch
+	// are merged into one UpdateQuery and repeated arrow keys into one
+	// MoveSelection.
+	void poll(std::string& query, const SearchEngine& engine,
+	          SafeQueue<Command>& queue);
+
+	// Decodes bytes read elsewhere, such as keys typed while the
+	// terminal was being probed, as if they had just arrived
+	void feed(const std::string_view bytes, std::string& query,
+	          const SearchEngine& engine, SafeQueue<Command>& queue);
+
+	// True while a partial escape sequence waits for more bytes
+	[[nodiscard]] bool awaiting_sequence() const;
+
+	// Called once Timing::EscapeTimeout passed without more input
+	void expire(std::string& query, const SearchEngine& engine,
+	            SafeQueue<Command>& queue);
 };
 
 #endif
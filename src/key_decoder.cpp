@@ -0,0 +1,197 @@
+#include "key_decoder.h"
+
+#include <algorithm>
+
+// ============================================================================
+// Key Tables
+// ============================================================================
+
+namespace {
+
+struct ControlEntry {
+	char byte = {};
+	Key key   = Key::Unknown;
+};
+
+// Single control bytes outside escape sequences
+constexpr std::array ControlTable = {
+        ControlEntry{0x03, Key::Interrupt}, // Ctrl+C
+        ControlEntry{0x08, Key::Backspace}, // Ctrl+H
+        ControlEntry{0x09, Key::Tab},
+        ControlEntry{0x0A, Key::Enter},
+        ControlEntry{0x0D, Key::Enter},
+        ControlEntry{0x15, Key::ClearLine},  // Ctrl+U
+        ControlEntry{0x17, Key::DeleteWord}, // Ctrl+W
+        ControlEntry{0x7F, Key::Backspace},
+};
+
+struct SequenceEntry {
+	char final_byte = {};
+	uint16_t number = {}; // first parameter of "~" sequences
+	Key key         = Key::Unknown;
+};
+
+// CSI sequences: "ESC [ <mods> A" style and "ESC [ <n> ; <mods> ~" style
+constexpr std::array CsiTable = {
+        SequenceEntry{'A', 0, Key::Up},
+        SequenceEntry{'B', 0, Key::Down},
+        SequenceEntry{'C', 0, Key::Right},
+        SequenceEntry{'D', 0, Key::Left},
+        SequenceEntry{'H', 0, Key::Home},
+        SequenceEntry{'F', 0, Key::End},
+        SequenceEntry{'Z', 0, Key::BackTab},
+        SequenceEntry{'~', 1, Key::Home},
+        SequenceEntry{'~', 2, Key::Insert},
+        SequenceEntry{'~', 3, Key::Delete},
+        SequenceEntry{'~', 4, Key::End},
+        SequenceEntry{'~', 5, Key::PageUp},
+        SequenceEntry{'~', 6, Key::PageDown},
+        SequenceEntry{'~', 7, Key::Home},
+        SequenceEntry{'~', 8, Key::End},
+        SequenceEntry{'~', 200, Key::PasteBegin},
+        SequenceEntry{'~', 201, Key::PasteEnd},
+};
+
+// SS3 sequences sent in application cursor mode: "ESC O A"
+constexpr std::array Ss3Table = {
+        SequenceEntry{'A', 0, Key::Up},
+        SequenceEntry{'B', 0, Key::Down},
+        SequenceEntry{'C', 0, Key::Right},
+        SequenceEntry{'D', 0, Key::Left},
+        SequenceEntry{'H', 0, Key::Home},
+        SequenceEntry{'F', 0, Key::End},
+};
+
+constexpr char Esc = 0x1B;
+
+// xterm encodes modifiers as 1 + (Shift | Alt << 1 | Ctrl << 2)
+[[nodiscard]] constexpr uint8_t decode_modifiers(const uint16_t param)
+{
+	return (param > 1) ? static_cast<uint8_t>((param - 1) & 0x07)
+	                   : Modifier::None;
+}
+
+[[nodiscard]] constexpr Key lookup(const auto& table, const char final_byte,
+                                   const uint16_t number)
+{
+	const auto it = std::ranges::find_if(table, [&](const auto& entry) {
+		return entry.final_byte == final_byte && entry.number == number;
+	});
+	return (it != table.end()) ? it->key : Key::Unknown;
+}
+
+} // namespace
+
+// ============================================================================
+// Key Decoder
+// ============================================================================
+
+void KeyDecoder::begin_sequence(const State state)
+{
+	state_            = state;
+	params_           = {};
+	param_count_      = 0;
+	private_sequence_ = false;
+}
+
+[[nodiscard]] KeyEvent KeyDecoder::finish_csi(const char final_byte) const
+{
+	if (private_sequence_) {
+		return {};
+	}
+
+	const bool numbered    = (final_byte == '~');
+	const uint16_t number  = numbered ? params_[0] : 0;
+	const uint16_t mod_arg = (param_count_ > 1) ? params_[1] : 0;
+
+	return {lookup(CsiTable, final_byte, number),
+	        decode_modifiers(mod_arg)};
+}
+
+[[nodiscard]] std::optional<KeyEvent> KeyDecoder::feed(const char byte)
+{
+	const auto c = static_cast<unsigned char>(byte);
+
+	switch (state_) {
+	case State::Ground:
+		if (byte == Esc) {
+			begin_sequence(State::Escape);
+			return std::nullopt;
+		}
+		if (c < 0x20 || c == 0x7F) {
+			const auto it = std::ranges::find(ControlTable,
+			                                  byte,
+			                                  &ControlEntry::byte);
+			const bool known = (it != ControlTable.end());
+			return KeyEvent{known ? it->key : Key::Unknown};
+		}
+		// Printable ASCII and UTF-8 bytes are both text
+		return KeyEvent{Key::Text, Modifier::None, byte};
+
+	case State::Escape:
+		if (byte == '[') {
+			begin_sequence(State::Csi);
+			return std::nullopt;
+		}
+		if (byte == 'O') {
+			begin_sequence(State::Ss3);
+			return std::nullopt;
+		}
+		if (byte == Esc) {
+			// First Esc was a key of its own; the second may start
+			// a sequence
+			begin_sequence(State::Escape);
+			return KeyEvent{Key::Escape};
+		}
+		state_ = State::Ground;
+		if (c == 0x7F || c == 0x08) {
+			return KeyEvent{Key::DeleteWord, Modifier::Alt};
+		}
+		return KeyEvent{Key::Unknown, Modifier::Alt, byte};
+
+	case State::Csi:
+		if (c >= '0' && c <= '9') {
+			if (param_count_ == 0) {
+				param_count_ = 1;
+			}
+			auto& param = params_[param_count_ - 1];
+			param       = static_cast<uint16_t>(
+			        std::min(param * 10 + (c - '0'), 0xFFFF));
+			return std::nullopt;
+		}
+		if (byte == ';') {
+			const size_t count = std::max(param_count_, size_t(1));
+			param_count_       = std::min(count + 1, MaxParams);
+			return std::nullopt;
+		}
+		if (c >= 0x20 && c <= 0x3F) {
+			// Private markers ('<', '=', '>', '?') and
+			// intermediates
+			private_sequence_ = true;
+			return std::nullopt;
+		}
+		state_ = State::Ground;
+		if (c >= 0x40 && c <= 0x7E) {
+			return finish_csi(byte);
+		}
+		return KeyEvent{}; // malformed, drop it
+
+	case State::Ss3:
+		state_ = State::Ground;
+		return KeyEvent{lookup(Ss3Table, byte, 0)};
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] bool KeyDecoder::pending() const
+{
+	return state_ != State::Ground;
+}
+
+[[nodiscard]] std::optional<KeyEvent> KeyDecoder::expire()
+{
+	const bool lone_escape = (state_ == State::Escape);
+	state_                 = State::Ground;
+	return lone_escape ? std::optional<KeyEvent>(KeyEvent{Key::Escape})
+	                   : std::nullopt;
+}
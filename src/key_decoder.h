@@ -0,0 +1,79 @@
+#ifndef KEY_DECODER_H
+#define KEY_DECODER_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// ============================================================================
+// Key Decoder
+// ============================================================================
+
+enum class Key : uint8_t {
+	Unknown,
+	Text,
+	Enter,
+	Tab,
+	BackTab,
+	Backspace,
+	DeleteWord,
+	ClearLine,
+	Escape,
+	Interrupt,
+	Up,
+	Down,
+	Left,
+	Right,
+	Home,
+	End,
+	PageUp,
+	PageDown,
+	Insert,
+	Delete,
+	PasteBegin,
+	PasteEnd,
+};
+
+namespace Modifier {
+constexpr uint8_t None  = 0;
+constexpr uint8_t Shift = 1;
+constexpr uint8_t Alt   = 2;
+constexpr uint8_t Ctrl  = 4;
+} // namespace Modifier
+
+struct KeyEvent {
+	Key key           = Key::Unknown;
+	uint8_t modifiers = Modifier::None;
+	char byte         = {}; // for Key::Text
+};
+
+// Incremental decoder for terminal input. Bytes are fed one at a time and
+// the state survives between reads, so a sequence split across reads is
+// completed by the next one instead of being waited for.
+class KeyDecoder {
+	enum class State : uint8_t { Ground, Escape, Csi, Ss3 };
+
+	static constexpr size_t MaxParams = 4;
+
+	State state_                            = State::Ground;
+	std::array<uint16_t, MaxParams> params_ = {};
+	size_t param_count_                     = 0;
+	bool private_sequence_                  = false;
+
+	void begin_sequence(const State state);
+
+	[[nodiscard]] KeyEvent finish_csi(const char final_byte) const;
+
+public:
+	// Returns a key once the byte completes one
+	[[nodiscard]] std::optional<KeyEvent> feed(const char byte);
+
+	// True while a partial escape sequence is buffered
+	[[nodiscard]] bool pending() const;
+
+	// Resolves a partial sequence when no continuation byte arrived in
+	// time: a lone Esc is the Escape key, anything longer is dropped
+	[[nodiscard]] std::optional<KeyEvent> expire();
+};
+
+#endif
@@ -3,6 +3,7 @@
 // Licensed under GNU GPL v3+
 
 #include "application.h"
+#include "task_scheduler.h"
 #include "xml_parser.h"
 
 #include <iostream>
@@ -21,12 +22,15 @@ int main(const int argc, char* const argv[])
 			return ExitError;
 		}
 
-		auto entries = XMLParser::parse(argv[1]);
+		// Shared by loading, indexing and search
+		TaskScheduler scheduler;
+
+		auto entries = XMLParser::parse(argv[1], scheduler);
 		if (!entries) {
 			return ExitError;
 		}
 
-		Application app(std::move(*entries));
+		Application app(std::move(*entries), scheduler);
 		return app.run();
 	} catch (const std::exception& e) {
 		std::cerr << "Fatal error in main: " << e.what() << '\n';
@@ -0,0 +1,55 @@
+#include "next_words.h"
+
+#include <algorithm>
+
+// ============================================================================
+// Next Words
+// ============================================================================
+
+NextWords::NextWords(std::vector<std::pair<uint32_t, uint32_t>> pairs,
+                     const size_t term_count)
+{
+	std::ranges::sort(pairs);
+
+	struct Successor {
+		uint32_t term  = 0;
+		uint32_t count = 0;
+	};
+	std::vector<Successor> row = {};
+
+	first_.reserve(term_count + 1);
+	size_t i = 0;
+	for (uint32_t term = 0; term < term_count; ++term) {
+		first_.push_back(static_cast<uint32_t>(next_.size()));
+
+		// Count each distinct successor of this term
+		row.clear();
+		for (; i < pairs.size() && pairs[i].first == term; ++i) {
+			if (row.empty() || row.back().term != pairs[i].second) {
+				row.push_back({pairs[i].second, 0});
+			}
+			++row.back().count;
+		}
+
+		// Stable, so equally frequent successors stay in id order
+		std::ranges::stable_sort(row,
+		                         std::ranges::greater{},
+		                         &Successor::count);
+		const size_t kept = std::min(row.size(), MaxSuccessors);
+		for (size_t k = 0; k < kept; ++k) {
+			next_.push_back(row[k].term);
+		}
+	}
+	first_.push_back(static_cast<uint32_t>(next_.size()));
+	next_.shrink_to_fit();
+}
+
+[[nodiscard]] std::span<const uint32_t> NextWords::after(
+        const uint32_t term) const
+{
+	if (static_cast<size_t>(term) + 1 >= first_.size()) {
+		return {};
+	}
+	return std::span(next_).subspan(first_[term],
+	                                first_[term + 1] - first_[term]);
+}
@@ -0,0 +1,36 @@
+#ifndef NEXT_WORDS_H
+#define NEXT_WORDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// Next Words
+// ============================================================================
+
+// Bigram table over vocabulary term ids: for each term, the terms that most
+// often follow it within a title, most frequent first. Built once at load
+// in compressed rows, so a lookup is two reads.
+class NextWords {
+	std::vector<uint32_t> first_ = {}; // row t ends where row t + 1 begins
+	std::vector<uint32_t> next_  = {};
+
+public:
+	static constexpr size_t MaxSuccessors = 4;
+
+	NextWords() = default;
+
+	// pairs holds a (term, following term) pair per occurrence; ids must
+	// be below term_count
+	NextWords(std::vector<std::pair<uint32_t, uint32_t>> pairs,
+	          const size_t term_count);
+
+	// Successors of the term, most frequent first and by id among equals
+	[[nodiscard]] std::span<const uint32_t> after(
+	        const uint32_t term) const;
+};
+
+#endif
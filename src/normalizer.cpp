@@ -0,0 +1,262 @@
+#include "normalizer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+// ============================================================================
+// Normalizer
+// ============================================================================
+
+namespace {
+
+constexpr std::string_view RightQuote = "\xE2\x80\x99";
+
+// Decimal spellings of the numerals roman_value() accepts, by value
+constexpr auto Decimals = [] {
+	std::array<std::array<char, 2>, Normalizer::MaxRoman + 1> digits = {};
+	for (size_t i = 0; i < digits.size(); ++i) {
+		digits[i] = {static_cast<char>('0' + i / 10),
+		             static_cast<char>('0' + i % 10)};
+	}
+	return digits;
+}();
+
+[[nodiscard]] std::string to_roman(int value)
+{
+	constexpr std::array<std::pair<int, std::string_view>, 5> Digits = {
+	        {{10, "x"}, {9, "ix"}, {5, "v"}, {4, "iv"}, {1, "i"}}};
+
+	std::string roman = {};
+	for (const auto& [digit_value, digit] : Digits) {
+		for (; value >= digit_value; value -= digit_value) {
+			roman += digit;
+		}
+	}
+	return roman;
+}
+
+// The words of lowercase text in canonical form. A numeral opening the
+// text is left alone, as in "I Have No Mouth" or "X-Wing".
+[[nodiscard]] std::vector<std::string> canonical_words(
+        const std::string_view text)
+{
+	std::vector<std::string> words = {};
+	size_t previous_end            = 0;
+
+	for (const auto token : Util::tokenize(text)) {
+		const auto pos = static_cast<size_t>(token.data() -
+		                                     text.data());
+
+		// Joined only when the apostrophe sits between the two, so
+		// the quoted 'n' of "rock 'n' roll" stays a word
+		const size_t gap = pos - previous_end;
+		const bool joined = !words.empty() &&
+		                    Normalizer::follows_apostrophe(text, pos) &&
+		                    (gap == 1 || gap == RightQuote.size());
+		if (joined) {
+			words.back() += token;
+		} else {
+			words.emplace_back(token);
+		}
+		previous_end = pos + token.size();
+	}
+
+	for (auto& word : words | std::views::drop(1)) {
+		const int value = Normalizer::roman_value(word);
+		if (value != 0) {
+			word = std::to_string(value);
+		}
+	}
+	return words;
+}
+
+// The text from the start of first to the end of last
+[[nodiscard]] std::string_view run(const std::string_view first,
+                                   const std::string_view last)
+{
+	const auto end = last.data() + last.size();
+	return {first.data(), static_cast<size_t>(end - first.data())};
+}
+
+// Words separated by blanks, as one string
+[[nodiscard]] std::string join(const std::vector<std::string>& words)
+{
+	std::string text = {};
+	for (const auto& word : words) {
+		if (!text.empty()) {
+			text += ' ';
+		}
+		text += word;
+	}
+	return text;
+}
+
+} // namespace
+
+Normalizer::Normalizer(const std::string_view synonyms)
+{
+	for (const auto line : std::views::split(synonyms, '\n')) {
+		const auto lower = Util::to_lower(std::string_view(line));
+		if (lower.empty() || lower.front() == '#') {
+			continue;
+		}
+
+		std::vector<Phrase> group = {};
+		for (const auto member : std::views::split(lower, ',')) {
+			auto phrase = canonical_words(std::string_view(member));
+			if (!phrase.empty()) {
+				group.push_back(std::move(phrase));
+			}
+		}
+		if (group.size() > 1) {
+			groups_.push_back(std::move(group));
+		}
+	}
+}
+
+[[nodiscard]] std::optional<Normalizer> Normalizer::load(
+        const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::cerr << "Error: Cannot open synonyms file " << path
+		          << '\n';
+		return std::nullopt;
+	}
+
+	const std::string text(std::istreambuf_iterator<char>(file), {});
+	return Normalizer(text);
+}
+
+[[nodiscard]] int Normalizer::roman_value(const std::string_view token)
+{
+	const auto digit = [](const char c) {
+		return (c == 'i') ? 1 : (c == 'v') ? 5 : (c == 'x') ? 10 : 0;
+	};
+
+	int value = 0;
+	for (size_t i = 0; i < token.size(); ++i) {
+		const int d = digit(token[i]);
+		if (d == 0) {
+			return 0;
+		}
+		const int next = (i + 1 < token.size()) ? digit(token[i + 1])
+		                                        : 0;
+		value += (d < next) ? -d : d;
+	}
+
+	// Rejects "iix", "vv" and the like, which add up but aren't numerals
+	if (value <= 0 || value > MaxRoman || to_roman(value) != token) {
+		return 0;
+	}
+	return value;
+}
+
+[[nodiscard]] bool Normalizer::follows_apostrophe(const std::string_view text,
+                                                  const size_t pos)
+{
+	const auto before = text.substr(0, pos);
+	return before.ends_with('\'') || before.ends_with(RightQuote);
+}
+
+[[nodiscard]] std::string_view Normalizer::normalize(
+        const std::string_view word)
+{
+	const int value = roman_value(word);
+	if (value == 0) {
+		return word;
+	}
+	const auto& digits = Decimals[static_cast<size_t>(value)];
+	return (value < 10) ? std::string_view(&digits[1], 1)
+	                    : std::string_view(digits.data(), 2);
+}
+
+[[nodiscard]] std::optional<std::string> Normalizer::respell(
+        const std::string_view name)
+{
+	const auto canonical = canonical_words(name);
+	if (std::ranges::equal(canonical, Util::tokenize(name))) {
+		return std::nullopt;
+	}
+	return join(canonical);
+}
+
+void Normalizer::append_extra_words(const std::string_view name,
+                                    std::vector<std::string>& words) const
+{
+	const auto canonical = canonical_words(name);
+	const auto written   = Util::tokenize(name);
+
+	for (const auto& word : canonical) {
+		if (std::ranges::find(written, word) == written.end()) {
+			words.push_back(word);
+		}
+	}
+
+	// A group whose phrase the name holds lends it all its phrases, each
+	// whole: "war" alone doesn't stand for "great war". The caller drops
+	// the duplicates.
+	for (const auto& group : groups_) {
+		const auto in_name = [&](const Phrase& phrase) {
+			return !std::ranges::search(canonical, phrase).empty();
+		};
+		if (std::ranges::any_of(group, in_name)) {
+			for (const auto& phrase : group) {
+				words.push_back(join(phrase));
+			}
+		}
+	}
+}
+
+void Normalizer::find_spelling(const std::string_view word,
+                               const std::string_view text,
+                               const std::span<const std::string_view> words,
+                               std::vector<std::string_view>& found) const
+{
+	for (size_t i = 0; i < words.size(); ++i) {
+		const auto token = words[i];
+		if (normalize(token) == word) {
+			found.push_back(token);
+			return;
+		}
+		if (i + 1 == words.size() || !word.starts_with(token)) {
+			continue;
+		}
+		const auto next = words[i + 1];
+		const auto pos  = static_cast<size_t>(next.data() -
+		                                      text.data());
+		if (follows_apostrophe(text, pos) &&
+		    word.substr(token.size()) == next) {
+			found.push_back(run(token, next));
+			return;
+		}
+	}
+
+	const auto same = [](const std::string_view token,
+	                     const std::string& canonical) {
+		return normalize(token) == canonical;
+	};
+	for (const auto& group : groups_) {
+		const auto holds_word = [&](const Phrase& phrase) {
+			return std::ranges::find(phrase, word) != phrase.end();
+		};
+		if (!std::ranges::any_of(group, holds_word)) {
+			continue;
+		}
+		for (const auto& phrase : group) {
+			const auto hit = std::ranges::search(words,
+			                                     phrase,
+			                                     same);
+			if (!hit.empty()) {
+				found.push_back(run(hit.front(), hit.back()));
+				return;
+			}
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef NORMALIZER_H
+#define NORMALIZER_H
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Normalizer
+// ============================================================================
+
+// Canonical spellings of words, so "kings quest 5" finds King's Quest V:
+// words are joined over apostrophes, and roman numerals become digits.
+// A synonym table read from a user's file adds equivalents on top, such as
+// "ww2" for World War II. The index stores the canonical words an entry's
+// names spell, and its synonyms as whole phrases, so a query in any of
+// these forms is a posting lookup per word or run of words.
+class Normalizer {
+	// A synonym as canonical words; a group holds equivalent ones
+	using Phrase = std::vector<std::string>;
+
+	std::vector<std::vector<Phrase>> groups_ = {};
+
+public:
+	// Sequel numbers go no higher than this in practice; larger numerals
+	// are more often words, such as "mix" or "civ"
+	static constexpr int MaxRoman = 39;
+
+	Normalizer() = default;
+
+	// Reads synonym groups, one per line with their members separated by
+	// commas, such as "ww2, wwii, world war 2". Blank lines and lines
+	// starting with '#' are skipped.
+	explicit Normalizer(const std::string_view synonyms);
+
+	// Reads the synonym file at path; reports and returns nothing if it
+	// can't be read
+	[[nodiscard]] static std::optional<Normalizer> load(
+	        const std::string& path);
+
+	// Value of a lowercase roman numeral up to MaxRoman written the usual
+	// way; zero for anything else
+	[[nodiscard]] static int roman_value(const std::string_view token);
+
+	// True if the token at pos directly follows an apostrophe, as the "s"
+	// of "king's" does
+	[[nodiscard]] static bool follows_apostrophe(
+	        const std::string_view text, const size_t pos);
+
+	// The canonical form of a lowercase query word: the word itself, or
+	// static digits for a numeral, so the search path doesn't allocate
+	[[nodiscard]] static std::string_view normalize(
+	        const std::string_view word);
+
+	// The canonical words of a lowercase name separated by blanks, or
+	// nothing if they are the words as written
+	[[nodiscard]] static std::optional<std::string> respell(
+	        const std::string_view name);
+
+	// Appends the canonical words of a lowercase name that tokenizing it
+	// as written misses, and every synonym of a phrase it holds, with its
+	// words separated by blanks
+	void append_extra_words(const std::string_view name,
+	                        std::vector<std::string>& words) const;
+
+	// Appends to found the first run of words that spells a canonical
+	// query word another way: one word written differently, two joined
+	// over an apostrophe, or a synonym of a phrase holding the word.
+	// Words are the tokens of lowercase text; nothing is appended if
+	// none spells it.
+	void find_spelling(const std::string_view word,
+	                   const std::string_view text,
+	                   const std::span<const std::string_view> words,
+	                   std::vector<std::string_view>& found) const;
+};
+
+#endif
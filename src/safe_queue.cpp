@@ -1,16 +1,62 @@
 #include "safe_queue.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
 // ============================================================================
 // Thread-Safe Queue
 // ============================================================================
 
+template <class T>
+[[nodiscard]] bool SafeQueue<T>::has_items() const
+{
+	return std::ranges::any_of(lanes_, [](const auto& lane) {
+		return !lane.empty();
+	});
+}
+
+// Serves the highest-priority non-empty lane
+template <class T>
+[[nodiscard]] std::optional<T> SafeQueue<T>::take_highest()
+{
+	for (auto& lane : lanes_) {
+		if (!lane.empty()) {
+			T item = std::move(lane.items[lane.head++]);
+			if (lane.empty()) {
+				lane.items.clear();
+				lane.head = 0;
+			}
+			return item;
+		}
+	}
+	return std::nullopt;
+}
+
 // 2. Universal reference for efficient push
 template <class T>
 void SafeQueue<T>::push(T&& item)
 {
 	{
 		std::scoped_lock lock(mutex_);
-		queue_.push(std::forward<T>(item));
+
+		// Drop queued work the new item makes obsolete
+		for (auto& lane : lanes_) {
+			auto first = lane.items.begin();
+			std::advance(first, lane.head);
+
+			const auto obsolete = std::remove_if(
+			        first,
+			        lane.items.end(),
+			        [&item](const T& queued) {
+				        return Traits::supersedes(item, queued);
+			        });
+			lane.items.erase(obsolete, lane.items.end());
+		}
+
+		const size_t lane = std::min(Traits::lane(item),
+		                             Traits::Lanes - 1);
+		lanes_[lane].items.push_back(std::forward<T>(item));
 	}
 	cv_.notify_one();
 }
@@ -20,12 +66,7 @@ template <class T>
 [[nodiscard]] std::optional<T> SafeQueue<T>::try_pop()
 {
 	std::scoped_lock lock(mutex_);
-	if (queue_.empty()) {
-		return std::nullopt;
-	}
-	T item = std::move(queue_.front());
-	queue_.pop();
-	return item;
+	return take_highest();
 }
 
 // 4. Blocking pop with timeout
@@ -34,19 +75,12 @@ template <class T>
 {
 	std::unique_lock lock(mutex_);
 	if (!cv_.wait_for(lock, timeout, [this] {
-		    return !queue_.empty() ||
+		    return has_items() ||
 		           !running_.load(std::memory_order_relaxed);
 	    })) {
 		return std::nullopt;
 	}
-
-	if (queue_.empty()) {
-		return std::nullopt;
-	}
-
-	T item = std::move(queue_.front());
-	queue_.pop();
-	return item;
+	return take_highest();
 }
 
 // 5. Blocking pop without timeout
@@ -55,16 +89,9 @@ template <class T>
 {
 	std::unique_lock lock(mutex_);
 	cv_.wait(lock, [this] {
-		return !queue_.empty() || !running_.load(std::memory_order_relaxed);
+		return has_items() || !running_.load(std::memory_order_relaxed);
 	});
-
-	if (queue_.empty()) {
-		return std::nullopt;
-	}
-
-	T item = std::move(queue_.front());
-	queue_.pop();
-	return item;
+	return take_highest();
 }
 
 template <class T>
@@ -79,7 +106,11 @@ template <class T>
 [[nodiscard]] size_t SafeQueue<T>::size() const
 {
 	std::scoped_lock lock(mutex_);
-	return queue_.size();
+	size_t total = 0;
+	for (const auto& lane : lanes_) {
+		total += lane.items.size() - lane.head;
+	}
+	return total;
 }
 
 // 7. Thread-safe empty check
@@ -87,7 +118,7 @@ template <class T>
 [[nodiscard]] bool SafeQueue<T>::empty() const
 {
 	std::scoped_lock lock(mutex_);
-	return queue_.empty();
+	return !has_items();
 }
 
 // Explicit instantiations
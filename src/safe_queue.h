@@ -1,12 +1,35 @@
 #ifndef SAFE_QUEUE_H
 #define SAFE_QUEUE_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
-#include <queue>
+#include <vector>
+
+// ============================================================================
+// Queue Traits
+// ============================================================================
+
+// Lane assignment and coalescing rules for queued items. Lane 0 is always
+// served first. Specialize for item types that need priorities.
+template <typename T>
+struct QueueTraits {
+	static constexpr size_t Lanes = 1;
+
+	[[nodiscard]] static constexpr size_t lane(const T&)
+	{
+		return 0;
+	}
+
+	// True if a newly pushed item makes an already queued one obsolete
+	[[nodiscard]] static constexpr bool supersedes(const T&, const T&)
+	{
+		return false;
+	}
+};
 
 // ============================================================================
 // Thread-Safe Queue
@@ -14,21 +37,35 @@
 
 template <typename T>
 class SafeQueue {
-	std::queue<T> queue_;
+	using Traits = QueueTraits<T>;
+
+	// FIFO over a vector that is rewound whenever it drains, so a queue
+	// that is emptied regularly stops allocating once it has grown
+	struct Fifo {
+		std::vector<T> items = {};
+		size_t head          = 0;
+
+		[[nodiscard]] bool empty() const
+		{
+			return head == items.size();
+		}
+	};
+
+	std::array<Fifo, Traits::Lanes> lanes_;
 	mutable std::mutex mutex_;
 	std::condition_variable cv_;
 	std::atomic<bool> running_{true};
 
+	// Callers must hold mutex_
+	[[nodiscard]] bool has_items() const;
+	[[nodiscard]] std::optional<T> take_highest();
+
 public:
-	// 1. Perfect forwarding - constructs T in-place
+	// 1. Perfect forwarding - constructs T before lane assignment
 	template <typename... Args>
 	void emplace(Args&&... items)
 	{
-		{
-			std::scoped_lock lock(mutex_);
-			queue_.emplace(std::forward<Args>(items)...);
-		}
-		cv_.notify_one();
+		push(T(std::forward<Args>(items)...));
 	}
 	// 2. Universal reference for efficient push
 	void push(T&& item);
@@ -1,39 +1,203 @@
 #include "search_engine.h"
-#include "timing_t.h"
 #include "utilities.h"
 
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <memory>
+#include <numeric>
 #include <ranges>
-#include <set>
+#include <utility>
 
 // ============================================================================
 // Search Engine
 // ============================================================================
 
+namespace {
+constexpr size_t ScoreGrain = 512; // entries scored per task
+constexpr size_t IndexGrain = 256; // entries tokenized per task
+
+// Query words shorter than this aren't corrected, and from the long
+// length on two edits are allowed instead of one
+constexpr size_t SimilarMinLength  = 4;
+constexpr size_t SimilarLongLength = 8;
+// Bits in a WordHits mask
+constexpr size_t MaxMaskedWords = 32;
+
+// Shorter words would match nearly every folder name, and longer ones
+// don't fit a pattern mask
+constexpr size_t SubsequenceMinLength = 2;
+constexpr size_t MaxSubsequenceLength = 64;
+
+// Letters skipped inside a subsequence match cost a point each, up to
+// this many
+constexpr int MaxSubsequencePenalty = 3;
+
+constexpr uint32_t NoTerm = UINT32_MAX;
+
+// The DOS folder name a key ends in, such as "captlsm"
+[[nodiscard]] std::string_view folder_name(const std::string_view key)
+{
+	const size_t slash = key.find_last_of("\\/");
+	return (slash == std::string_view::npos) ? key : key.substr(slash + 1);
+}
+
+// Fills in the lowercased copies of an entry, its words and its width
+void prepare_entry(Entry& entry)
+{
+	entry.lower_key     = Util::to_lower(entry.key);
+	entry.lower_content = Util::to_lower(entry.content);
+	entry.words         = Util::tokenize(entry.lower_content);
+	entry.content_width = Unicode::measure(entry.content,
+	                                       entry.content_stops);
+}
+
+// Appends the canonical spellings the names of an entry don't use as
+// written, and their synonyms. The names are kept respelled only if
+// some name is spelled differently, for the sequential bonus of
+// respelled queries.
+void add_spellings(Entry& entry, const Normalizer& normalizer,
+                   std::vector<std::string>& extra_words)
+{
+	const std::string_view content = entry.lower_content;
+
+	std::string canonical = {};
+	bool respelled        = false;
+	for (const auto& range : entry.names) {
+		const auto name = content.substr(range.begin, range.length);
+		normalizer.append_extra_words(name, extra_words);
+
+		const auto respelling = Normalizer::respell(name);
+		respelled = respelled || respelling.has_value();
+		canonical += respelling ? std::string_view(*respelling) : name;
+		canonical += ' ';
+	}
+	if (respelled) {
+		entry.canonical_content = std::move(canonical);
+	}
+}
+
+// Where the letters of word appear in order in name: the first match is
+// narrowed from its end back to the latest start, fzf's way
+struct Window {
+	size_t begin = 0;
+	size_t end   = 0;
+};
+
+[[nodiscard]] Window subsequence_window(const std::string_view name,
+                                        const std::string_view word)
+{
+	size_t end = 0;
+	for (size_t w = 0; end < name.size() && w < word.size(); ++end) {
+		if (name[end] == word[w]) {
+			++w;
+		}
+	}
+
+	size_t begin = end;
+	for (size_t w = word.size(); begin > 0 && w > 0;) {
+		if (name[--begin] == word[w - 1]) {
+			--w;
+		}
+	}
+	return {begin, end};
+}
+
+// Gap-aware score of a word whose letters appear in order in name: the
+// letters left inside the window between the matched ones are the gaps
+[[nodiscard]] int subsequence_score(const std::string_view name,
+                                    const std::string_view word,
+                                    const int best)
+{
+	const auto [begin, end] = subsequence_window(name, word);
+	const size_t gaps = (end - begin) - word.size() + (begin > 0 ? 1 : 0);
+	return best - std::min(static_cast<int>(gaps), MaxSubsequencePenalty);
+}
+
+// Where part, a view into text, starts in it
+[[nodiscard]] uint32_t offset_in(const std::string_view text,
+                                 const std::string_view part)
+{
+	return static_cast<uint32_t>(part.data() - text.data());
+}
+
+// The words of an entry lying in one of its names
+[[nodiscard]] std::span<const std::string_view> name_words(
+        const Entry& entry, const NameRange& range)
+{
+	const char* const begin = entry.lower_content.data() + range.begin;
+	const char* const end   = begin + range.length;
+
+	const auto& words = entry.words;
+	const auto data   = [](const std::string_view w) { return w.data(); };
+	const auto first  = std::ranges::lower_bound(words, begin, {}, data);
+	const auto last   = std::ranges::lower_bound(words, end, {}, data);
+	return {first, last};
+}
+
+// Appends the initials and numbers of the first name of entry that
+// spells the acronym
+void find_acronym(const Entry& entry, const std::string_view acronym,
+                  std::vector<std::string_view>& pieces)
+{
+	const std::string_view content = entry.lower_content;
+	for (const auto& range : entry.names) {
+		const auto name = content.substr(range.begin, range.length);
+		if (AcronymIndex::spell(name,
+		                        name_words(entry, range),
+		                        acronym,
+		                        pieces)) {
+			return;
+		}
+	}
+}
+
+// Extends into to cover span when both are in the same field and overlap
+[[nodiscard]] bool merge_span(MatchSpan& into, const MatchSpan& span)
+{
+	const uint32_t end = into.begin + into.length;
+	if (into.field != span.field || span.begin > end) {
+		return false;
+	}
+	const uint32_t last = std::max(end, span.begin + span.length);
+	into.length         = static_cast<uint16_t>(last - into.begin);
+	return true;
+}
+} // namespace
+
 namespace Score {
 constexpr int SequentialKey     = 5000;
+constexpr int SequentialWords   = 4000;
 constexpr int SequentialContent = 3000;
 constexpr int KeyPrefix         = 2000;
+constexpr int Acronym           = 1500; // beats a few letters inside a key
 constexpr int KeyContains       = 1000;
 constexpr int WordPrefix        = 100;
 constexpr int WordContains      = 50;
 constexpr int Content           = 10;
+constexpr int Similar           = 5;
+constexpr int Subsequence       = 4; // less its gaps
 constexpr int Default           = 1;
 constexpr int None              = 0;
 } // namespace Score
 
 [[nodiscard]] bool SearchEngine::has_sequential_match(
-        const std::string_view text, const std::vector<std::string_view>& words)
+        const std::string_view text,
+        const std::span<const std::string_view> words,
+        const bool at_word_starts)
 {
 	if (words.empty()) {
 		return false;
 	}
 
-	const auto lower = Util::to_lower(text);
-	size_t pos       = 0;
+	size_t pos = 0;
 
 	for (const auto& word : words) {
-		pos = lower.find(word, pos);
+		pos = text.find(word, pos);
+		while (at_word_starts && pos != std::string::npos && pos > 0 &&
+		       std::isalnum(static_cast<uint8_t>(text[pos - 1]))) {
+			pos = text.find(word, pos + 1);
+		}
 		if (pos == std::string::npos) {
 			return false;
 		}
@@ -42,256 +206,796 @@ constexpr int None              = 0;
 	return true;
 }
 
-[[nodiscard]] int SearchEngine::score(const Entry& entry,
-                                      const std::string_view query) const
+// Words are the lowercased query tokens and canonical their canonical
+// forms; entries carry lowercase copies of their text, so scoring never
+// allocates
+[[nodiscard]] int SearchEngine::score(
+        const Entry& entry,
+        const std::span<const std::string_view> words,
+        const std::span<const std::string_view> canonical,
+        const WordHits& hits,
+        const std::span<WordMatch> matches)
 {
-	if (query.empty()) {
-		return Score::Default;
-	}
-
-	const auto query_words = Util::tokenize(query);
-	if (query_words.empty()) {
+	if (words.empty()) {
 		return Score::Default;
 	}
 
-	int result               = Score::None;
-	const auto lower_key     = Util::to_lower(entry.key);
-	const auto lower_content = Util::to_lower(entry.content);
+	int result = Score::None;
 
 	// Sequential matching bonus
-	if (query_words.size() > 1) {
-		if (has_sequential_match(entry.key, query_words)) {
+	if (words.size() > 1) {
+		const std::string_view content   = entry.lower_content;
+		const std::string_view respelled = entry.canonical_content;
+		if (has_sequential_match(entry.lower_key, words)) {
 			result += Score::SequentialKey;
-		} else if (has_sequential_match(entry.content, query_words)) {
+		} else if (has_sequential_match(content, words, true) ||
+		           has_sequential_match(respelled, canonical, true)) {
+			result += Score::SequentialWords;
+		} else if (has_sequential_match(content, words) ||
+		           has_sequential_match(respelled, canonical)) {
 			result += Score::SequentialContent;
 		}
 	}
 
 	// Per-word matching
-	for (const auto& qword : query_words) {
-		int word_score = Score::None;
+	const std::string_view content = entry.lower_content;
+	for (size_t w = 0; w < words.size(); ++w) {
+		const auto& qword  = words[w];
+		const uint32_t bit = (w < MaxMaskedWords) ? (1U << w) : 0;
+		int word_score     = Score::None;
+		WordMatch match    = {};
 
 		// Check key matches
-		if (lower_key.starts_with(qword)) {
-			word_score = Score::KeyPrefix;
-		} else if (lower_key.find(qword) != std::string::npos) {
-			word_score = Score::KeyContains;
+		const size_t key_pos = entry.lower_key.find(qword);
+		if (key_pos != std::string::npos) {
+			word_score = (key_pos == 0) ? Score::KeyPrefix
+			                            : Score::KeyContains;
+			match.key  = static_cast<uint32_t>(key_pos);
 		}
 
-		// Check entry word matches
+		// Check entry word matches, keeping where the best one lies
+		int word_class  = Score::None;
+		bool whole_word = false;
 		for (const auto& eword : entry.words) {
-			if (eword.starts_with(qword)) {
-				word_score = std::max(word_score, Score::WordPrefix);
-			} else if (eword.find(qword) != std::string::npos) {
-				word_score = std::max(word_score, Score::WordContains);
+			whole_word       = whole_word || (eword == qword);
+			const size_t pos = eword.find(qword);
+			if (pos == std::string::npos) {
+				continue;
+			}
+			const int found = (pos == 0) ? Score::WordPrefix
+			                             : Score::WordContains;
+			if (found > word_class) {
+				word_class    = found;
+				match.content = offset_in(content, eword) +
+				                static_cast<uint32_t>(pos);
 			}
 		}
 
 		// Check content match
-		if (lower_content.find(qword) != std::string::npos) {
-			word_score = std::max(word_score, Score::Content);
+		if (word_class == Score::None) {
+			const size_t pos = content.find(qword);
+			if (pos != std::string::npos) {
+				word_class    = Score::Content;
+				match.content = static_cast<uint32_t>(pos);
+			}
+		}
+		word_score = std::max(word_score, word_class);
+		if (word_score != Score::None) {
+			match.kind = MatchKind::Literal;
+		}
+
+		// Initialisms like "kq5" for King's Quest V, looked up in the
+		// acronym table before the scan. They add to a folder name or
+		// a whole word spelled the same, so the KQ5 folder ranks first,
+		// but not to letters inside some other word, as in "mission".
+		if ((hits.acronym & bit) != 0) {
+			const auto folder = folder_name(entry.lower_key);
+			if (whole_word || folder.starts_with(qword)) {
+				word_score += Score::Acronym;
+				match.kind  = MatchKind::Acronym;
+			} else if (word_score < Score::Acronym) {
+				word_score = Score::Acronym;
+				match      = {.kind = MatchKind::Acronym};
+			}
+		}
+
+		// Other spellings of a whole word, such as "kings" for "king's"
+		// or "5" for "V", indexed as terms of the entry. When the key
+		// matched as typed, the spelling is still what the content
+		// holds.
+		if ((hits.equivalent & bit) != 0) {
+			if (word_score < Score::WordPrefix) {
+				word_score = Score::WordPrefix;
+				match      = {.kind = MatchKind::Equivalent};
+			} else if (match.kind == MatchKind::Literal &&
+			           match.content == WordMatch::NoPosition) {
+				match.kind = MatchKind::Equivalent;
+			}
+		}
+
+		// A typo costs no more than this lookup: the terms near the
+		// word were expanded into the bit before the scan
+		if (word_score == Score::None && (hits.similar & bit) != 0) {
+			word_score = Score::Similar;
+			match.kind = MatchKind::Similar;
+		}
+
+		// Abbreviations like "cptl" for "captlsm"; the bit is set by
+		// the column scan, so only hits pay for the gap count
+		if (word_score == Score::None &&
+		    (hits.subsequence & bit) != 0) {
+			const auto folder = folder_name(entry.lower_key);
+			word_score        = subsequence_score(
+			        folder, qword, Score::Subsequence);
+			match.kind        = MatchKind::Subsequence;
 		}
 
 		if (word_score == Score::None) {
 			return Score::None;
 		}
+		if (!matches.empty()) {
+			matches[w] = match;
+		}
 		result += word_score;
 	}
 	return result;
 }
 
-[[nodiscard]] std::vector<std::string> SearchEngine::find_completions(
-        const std::string_view query) const
+void SearchEngine::collect_spans(
+        const Entry& entry,
+        const std::span<const std::string_view> words,
+        const std::span<const std::string_view> canonical,
+        const std::span<const WordMatch> matches,
+        const std::span<const SimilarTerm> similar,
+        std::vector<MatchSpan>& spans)
 {
-	if (query.empty() || entries_.empty()) {
-		return {};
-	}
+	// Lowercasing keeps byte offsets, so these index the originals
+	const std::string_view key     = entry.lower_key;
+	const std::string_view content = entry.lower_content;
+	const size_t first             = spans.size();
 
-	const std::string q{query};
-	const size_t last_space = q.find_last_of(" \t");
-	const std::string word  = (last_space == std::string::npos)
-	                                ? q
-	                                : (last_space + 1 < q.length()
-	                                           ? q.substr(last_space + 1)
-	                                           : "");
+	const auto add = [&](const size_t begin,
+	                     const size_t length,
+	                     const MatchField field) {
+		spans.push_back({static_cast<uint32_t>(begin),
+		                 static_cast<uint16_t>(length),
+		                 field});
+	};
 
-	if (word.empty()) {
-		return {};
+	pieces_.clear();
+	for (size_t w = 0; w < matches.size(); ++w) {
+		const auto& match = matches[w];
+		const auto word   = words[w];
+		if (match.key != WordMatch::NoPosition) {
+			add(match.key, word.size(), MatchField::Key);
+		}
+		if (match.content != WordMatch::NoPosition) {
+			add(match.content, word.size(), MatchField::Content);
+		}
+
+		if (match.kind == MatchKind::Acronym) {
+			find_acronym(entry, word, pieces_);
+		} else if (match.kind == MatchKind::Equivalent) {
+			normalizer_.find_spelling(canonical[w],
+			                          content,
+			                          entry.words,
+			                          pieces_);
+		} else if (match.kind == MatchKind::Subsequence) {
+			// The letters the word takes in its tightest window
+			const auto folder = folder_name(key);
+			const auto offset = offset_in(key, folder);
+			size_t next       = 0;
+			for (size_t i = subsequence_window(folder, word).begin;
+			     next < word.size();
+			     ++i) {
+				if (folder[i] == word[next]) {
+					add(offset + i, 1, MatchField::Key);
+					++next;
+				}
+			}
+		} else if (match.kind == MatchKind::Similar) {
+			// The first word of the entry among the word's terms
+			const auto near = [&](const std::string_view eword) {
+				for (const auto& similar_term : similar) {
+					if (similar_term.word == w &&
+					    similar_term.term == eword) {
+						return true;
+					}
+				}
+				return false;
+			};
+			const auto& held = entry.words;
+			const auto found = std::ranges::find_if(held, near);
+			if (found != held.end()) {
+				pieces_.push_back(*found);
+			}
+		}
+	}
+	for (const auto piece : pieces_) {
+		add(offset_in(content, piece),
+		    piece.size(),
+		    MatchField::Content);
 	}
 
-	std::set<std::string> completions;
-	const auto lower_word = Util::to_lower(word);
+	const auto added = std::span(spans).subspan(first);
+	std::ranges::sort(added, [](const MatchSpan& a, const MatchSpan& b) {
+		return (a.field != b.field) ? (a.field < b.field)
+		                            : (a.begin < b.begin);
+	});
 
-	const auto check_candidate = [&](const std::string_view candidate) {
-		if (candidate.empty()) {
-			return;
+	// Merge overlapping spans of the same field
+	size_t out = first;
+	for (size_t i = first; i < spans.size(); ++i) {
+		if (out == first || !merge_span(spans[out - 1], spans[i])) {
+			spans[out++] = spans[i];
 		}
-		const auto lower = Util::to_lower(candidate);
-		if (lower.starts_with(lower_word) && lower.length() > word.length()) {
-			completions.emplace(std::string(candidate));
+	}
+	spans.resize(out);
+}
+
+void SearchEngine::find_similar(const std::span<const std::string_view> words,
+                                std::pmr::vector<SimilarTerm>& similar)
+{
+	for (size_t w = 0; w < std::min(words.size(), MaxMaskedWords); ++w) {
+		const auto word = words[w];
+		if (word.size() < SimilarMinLength) {
+			continue;
 		}
-	};
+		const size_t edits = (word.size() < SimilarLongLength) ? 1 : 2;
 
-	for (const auto& entry : entries_) {
-		check_candidate(entry.key);
-		for (const auto& w : entry.words) {
-			check_candidate(w);
+		similar_terms_.clear();
+		vocabulary_.find_similar(word, edits, similar_terms_);
+		for (const uint32_t t : similar_terms_) {
+			for (const uint32_t entry : postings(t)) {
+				word_hits_[entry].similar |= 1U << w;
+			}
+			// Terms keep the case they were first seen in, but
+			// spans are found among the lowercased words
+			const auto term = vocabulary_.term(t);
+			auto* lower     = static_cast<char*>(
+			        arena_.allocate(term.size(), 1));
+			std::ranges::transform(term, lower, [](const char c) {
+				const auto byte = static_cast<unsigned char>(c);
+				return static_cast<char>(std::tolower(byte));
+			});
+			if (const std::string_view folded(lower, term.size());
+			    folded != word) {
+				similar.push_back({w, folded});
+			}
 		}
 	}
-
-	return {completions.begin(), completions.end()};
 }
 
-void SearchEngine::search_worker(std::atomic<bool>& stop_flag)
+void SearchEngine::find_subsequences(
+        const std::span<const std::string_view> words)
 {
-	while (!stop_flag.load(std::memory_order_acquire)) {
-		if (!search_needed_.exchange(false)) {
-			std::this_thread::sleep_for(Timing::SearchSleep);
+	for (size_t w = 0; w < std::min(words.size(), MaxMaskedWords); ++w) {
+		const auto word = words[w];
+		if (word.size() < SubsequenceMinLength ||
+		    word.size() > MaxSubsequenceLength) {
 			continue;
 		}
 
-		const auto* qptr = query_.load(std::memory_order_acquire);
-		if (!qptr) {
-			std::this_thread::sleep_for(Timing::SearchSleep);
-			continue;
+		// Bit i of a byte's mask is set where the word has that byte
+		std::array<uint64_t, 256> masks = {};
+		for (size_t i = 0; i < word.size(); ++i) {
+			const auto c = static_cast<uint8_t>(word[i]);
+			masks[c] |= uint64_t{1} << i;
+		}
+		const uint64_t accept = uint64_t{1} << (word.size() - 1);
+
+		// Shift-and with self-loops: bit i of state is set once the
+		// first i + 1 letters have appeared in order, so every byte of
+		// the column costs a shift, an and and an or
+		const char* const column = key_column_.data();
+		for (size_t e = 0; e < entries_.size(); ++e) {
+			uint64_t state    = 0;
+			const size_t last = key_starts_[e + 1];
+			for (size_t i = key_starts_[e]; i < last; ++i) {
+				const auto c = static_cast<uint8_t>(column[i]);
+				state |= ((state << 1) | 1) & masks[c];
+			}
+			if ((state & accept) != 0) {
+				word_hits_[e].subsequence |= 1U << w;
+			}
+		}
+	}
+}
+
+void SearchEngine::find_equivalents(
+        const std::span<const std::string_view> canonical)
+{
+	// Synonyms of several words are terms of their own, looked up from
+	// runs of query words for as long as some term starts with the run
+	std::pmr::string phrase(&arena_);
+	const size_t count = std::min(canonical.size(), MaxMaskedWords);
+	for (size_t w = 0; w < count; ++w) {
+		phrase.assign(canonical[w]);
+		uint32_t bits = 1U << w;
+		for (size_t next = w + 1;; ++next) {
+			if (const auto term = vocabulary_.find(phrase)) {
+				for (const uint32_t entry : postings(*term)) {
+					word_hits_[entry].equivalent |= bits;
+				}
+			}
+			phrase += ' ';
+			if (next == count ||
+			    vocabulary_.complete(phrase).empty()) {
+				break;
+			}
+			phrase += canonical[next];
+			bits |= 1U << next;
+		}
+	}
+}
+
+void SearchEngine::find_acronyms(const std::span<const std::string_view> words)
+{
+	for (size_t w = 0; w < std::min(words.size(), MaxMaskedWords); ++w) {
+		for (const uint32_t entry : acronyms_.find(words[w])) {
+			word_hits_[entry].acronym |= 1U << w;
 		}
+	}
+}
 
-		const std::string q = *qptr;
+[[nodiscard]] std::span<const uint32_t> SearchEngine::postings(
+        const uint32_t term) const
+{
+	return std::span(postings_).subspan(posting_starts_[term],
+	                                    posting_starts_[term + 1] -
+	                                            posting_starts_[term]);
+}
 
-		auto new_results = std::make_unique<std::vector<SearchResult>>();
-		auto new_comps = std::make_unique<std::vector<std::string>>(
-		        find_completions(q));
+void SearchEngine::search_task(void* context)
+{
+	static_cast<SearchEngine*>(context)->run_searches();
+}
 
-		for (size_t i = 0; i < entries_.size(); ++i) {
-			const int s = score(entries_[i], q);
-			if (s > Score::None) {
-				new_results->emplace_back(SearchResult{i, s});
+void SearchEngine::run_searches()
+{
+	// Runs on the pool until no newer query is waiting
+	while (true) {
+		uint64_t generation = 0;
+		{
+			std::scoped_lock lock(search_mutex_);
+			if (stopping_ || !search_needed_.load()) {
+				search_running_ = false;
+				search_started_ = false;
+				return;
 			}
+			search_started_ = true;
+			search_needed_.store(false);
+			generation = requested_generation_;
+			search_query_.assign(query_);
+			search_group_.reset();
 		}
 
-		std::ranges::sort(*new_results, [this](const auto& a, const auto& b) {
+		// Everything query-sized lives in the arena until the next
+		// query. A search that overflowed it grows it, so repeating a
+		// long query allocates nothing.
+		arena_.release();
+		if (const size_t spilled = arena_spill_.take(); spilled > 0) {
+			grow_arena(arena_buffer_.size() + spilled);
+		}
+		std::pmr::string lower(search_query_, &arena_);
+		std::ranges::transform(lower, lower.begin(), [](const char c) {
+			return static_cast<char>(
+			        std::tolower(static_cast<unsigned char>(c)));
+		});
+
+		std::pmr::vector<std::string_view> words(&arena_);
+		Util::tokenize(lower, words);
+
+		std::pmr::vector<std::string_view> canonical(&arena_);
+		canonical.reserve(words.size());
+		for (const auto word : words) {
+			canonical.push_back(Normalizer::normalize(word));
+		}
+
+		std::pmr::vector<SimilarTerm> similar(&arena_);
+		word_hits_.assign(entries_.size(), {});
+		find_similar(words, similar);
+		find_subsequences(words);
+		find_acronyms(words);
+		find_equivalents(canonical);
+
+		auto& snapshot = snapshots_[back_];
+
+		const size_t chunks = (entries_.size() + ScoreGrain - 1) /
+		                      ScoreGrain;
+		chunk_results_.resize(chunks);
+
+		scheduler_.parallel_for(
+		        0,
+		        entries_.size(),
+		        ScoreGrain,
+		        [&](const size_t begin, const size_t end) {
+			        auto& out = chunk_results_[begin / ScoreGrain];
+			        out.clear();
+			        for (size_t i = begin; i < end; ++i) {
+				        const int s = score(entries_[i],
+				                            words,
+				                            canonical,
+				                            word_hits_[i]);
+				        if (s > Score::None) {
+					        out.push_back({i, s});
+				        }
+			        }
+		        },
+		        &search_group_);
+
+		// A newer query arrived mid-search; these results are stale
+		if (search_group_.is_cancelled()) {
+			continue;
+		}
+
+		auto& results = snapshot.results;
+		results.clear();
+		for (const auto& chunk : chunk_results_) {
+			results.insert(results.end(),
+			               chunk.begin(),
+			               chunk.end());
+		}
+
+		// Best first; ties in content order
+		const auto ranked = [this](const auto& a, const auto& b) {
 			return (a.score != b.score) ? (a.score > b.score)
 			                            : (entries_[a.index].content <
 			                               entries_[b.index].content);
-		});
+		};
+		std::ranges::sort(results, ranked);
+
+		if (results.size() > Display::MaxResults) {
+			results.resize(Display::MaxResults);
+		}
 
-		if (new_results->size() > Display::MaxResults) {
-			new_results->resize(Display::MaxResults);
+		// Spans only for the rows likely to be drawn, scored again to
+		// learn how each word matched
+		snapshot.spans.clear();
+		snapshot.span_starts.clear();
+		std::pmr::vector<WordMatch> matches(words.size(), &arena_);
+		const size_t highlighted =
+		        std::min(results.size(), Display::HighlightedResults);
+		for (size_t i = 0; i < highlighted; ++i) {
+			const auto index = results[i].index;
+			snapshot.span_starts.push_back(
+			        static_cast<uint32_t>(snapshot.spans.size()));
+			const auto& entry = entries_[index];
+			std::ranges::fill(matches, WordMatch{});
+			[[maybe_unused]] const int s = score(entry,
+			                                     words,
+			                                     canonical,
+			                                     word_hits_[index],
+			                                     matches);
+			collect_spans(entry,
+			              words,
+			              canonical,
+			              matches,
+			              similar,
+			              snapshot.spans);
 		}
+		snapshot.span_starts.push_back(
+		        static_cast<uint32_t>(snapshot.spans.size()));
 
-		delete results_.exchange(new_results.release(),
-		                         std::memory_order_acq_rel);
-		delete completions_.exchange(new_comps.release(),
-		                             std::memory_order_acq_rel);
+		snapshot.generation = generation;
+		publish();
 
 		if (queue_) {
 			queue_->emplace(RefreshDisplay{
 			        {0, -1, {}}
                         });
 		}
+		if (loop_) {
+			loop_->notify();
+		}
 	}
 }
 
-SearchEngine::SearchEngine(std::vector<Entry> entries)
+void* SearchEngine::ArenaSpill::do_allocate(const size_t bytes,
+                                            const size_t alignment)
+{
+	bytes_ += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void SearchEngine::ArenaSpill::do_deallocate(void* p, const size_t bytes,
+                                             const size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+[[nodiscard]] bool SearchEngine::ArenaSpill::do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+[[nodiscard]] size_t SearchEngine::ArenaSpill::take()
+{
+	return std::exchange(bytes_, 0);
+}
+
+void SearchEngine::grow_arena(const size_t bytes)
+{
+	// The resource can't be pointed at a new buffer, so it is rebuilt
+	// in place; it holds nothing once released
+	arena_buffer_.resize(bytes);
+	std::destroy_at(&arena_);
+	std::construct_at(&arena_,
+	                  arena_buffer_.data(),
+	                  arena_buffer_.size(),
+	                  &arena_spill_);
+}
+
+void SearchEngine::publish()
+{
+	back_ = ready_.exchange(back_ | FreshBit, std::memory_order_acq_rel) &
+	        ~FreshBit;
+}
+
+SearchEngine::SearchEngine(std::vector<Entry> entries, TaskScheduler& scheduler,
+                           Normalizer normalizer)
         : entries_(std::move(entries)),
-          results_(new std::vector<SearchResult>()),
-          completions_(new std::vector<std::string>()),
-          query_(new std::string())
-{}
+          normalizer_(std::move(normalizer)),
+          scheduler_(scheduler),
+          search_group_(scheduler),
+          arena_buffer_(ArenaBytes),
+          arena_(arena_buffer_.data(), arena_buffer_.size(), &arena_spill_)
+{
+	// Entries are final from here on, so the word views into their
+	// lowercased content stay valid
+	scheduler_.parallel_for(0,
+	                        entries_.size(),
+	                        IndexGrain,
+	                        [this](const size_t begin, const size_t end) {
+		                        for (size_t i = begin; i < end; ++i) {
+			                        prepare_entry(entries_[i]);
+		                        }
+	                        });
+
+	key_starts_.reserve(entries_.size() + 1);
+	key_starts_.push_back(0);
+	for (const auto& entry : entries_) {
+		key_column_ += folder_name(entry.lower_key);
+		const auto end = static_cast<uint32_t>(key_column_.size());
+		key_starts_.push_back(end);
+	}
+
+	// Keys go first so a key keeps its case over a word that differs
+	// from it only in case
+	std::vector<std::string_view> terms = {};
+	for (const auto& entry : entries_) {
+		terms.push_back(entry.key);
+	}
+	for (const auto& entry : entries_) {
+		terms.insert(terms.end(),
+		             entry.words.begin(),
+		             entry.words.end());
+	}
+
+	// Canonical spellings the names don't use as written, and their
+	// synonyms, are terms of their own
+	std::vector<std::vector<std::string>> extra_words(entries_.size());
+	scheduler_.parallel_for(0,
+	                        entries_.size(),
+	                        IndexGrain,
+	                        [&](const size_t begin, const size_t end) {
+		                        for (size_t i = begin; i < end; ++i) {
+			                        add_spellings(entries_[i],
+			                                      normalizer_,
+			                                      extra_words[i]);
+		                        }
+	                        });
+	for (const auto& words : extra_words) {
+		terms.insert(terms.end(), words.begin(), words.end());
+	}
+	vocabulary_ = Vocabulary(std::move(terms));
+
+	// As vocabulary ids: adjacent words of each title, and the terms
+	// each entry holds
+	std::vector<std::pair<uint32_t, uint32_t>> pairs       = {};
+	std::vector<std::pair<uint32_t, uint32_t>> occurrences = {};
+	for (uint32_t e = 0; e < entries_.size(); ++e) {
+		const auto& entry = entries_[e];
+		if (const auto id = vocabulary_.find(entry.key)) {
+			occurrences.emplace_back(*id, e);
+		}
+
+		const char* const title_end = entry.lower_content.data() +
+		                              entry.title_length;
+		uint32_t previous = NoTerm;
+		for (const auto word : entry.words) {
+			const auto found  = vocabulary_.find(word);
+			const uint32_t id = found.value_or(NoTerm);
+			if (found) {
+				occurrences.emplace_back(id, e);
+			}
+			const char* const word_end = word.data() + word.size();
+			const bool in_title        = (word_end <= title_end);
+			if (in_title && previous != NoTerm && id != NoTerm) {
+				pairs.emplace_back(previous, id);
+			}
+			previous = in_title ? id : NoTerm;
+		}
+
+		for (const auto& word : extra_words[e]) {
+			if (const auto id = vocabulary_.find(word)) {
+				occurrences.emplace_back(*id, e);
+			}
+		}
+	}
+	next_words_ = NextWords(std::move(pairs), vocabulary_.size());
+	acronyms_   = AcronymIndex(entries_);
+
+	std::ranges::sort(occurrences);
+	const auto repeats = std::ranges::unique(occurrences);
+	occurrences.erase(repeats.begin(), repeats.end());
+
+	posting_starts_.assign(vocabulary_.size() + 1, 0);
+	postings_.reserve(occurrences.size());
+	for (const auto& [term, entry] : occurrences) {
+		++posting_starts_[term + 1];
+		postings_.push_back(entry);
+	}
+	std::partial_sum(posting_starts_.begin(),
+	                 posting_starts_.end(),
+	                 posting_starts_.begin());
+}
 
 SearchEngine::~SearchEngine()
 {
-	delete results_.load();
-	delete completions_.load();
-	delete query_.load();
+	stop();
 }
 
-void SearchEngine::set_queue(SafeQueue<Command>* q)
+void SearchEngine::set_queue(SafeQueue<Command>* q, EventLoop* loop)
 {
 	queue_ = q;
+	loop_  = loop;
 }
 
-[[nodiscard]] std::thread SearchEngine::start(std::atomic<bool>& stop_flag)
+void SearchEngine::stop()
 {
-	return std::thread([this, &stop_flag]() { search_worker(stop_flag); });
+	{
+		std::scoped_lock lock(search_mutex_);
+		stopping_ = true;
+		search_group_.cancel();
+	}
+	search_group_.wait();
 }
 
 void SearchEngine::update_query(const std::string& q)
 {
-	delete query_.exchange(new std::string(q), std::memory_order_acq_rel);
-	search_needed_.store(true, std::memory_order_release);
+	bool dispatch = false;
+	{
+		// Cancelling under the lock pairs with the reset in
+		// run_searches(), so only a superseded search is aborted. A
+		// task still queued is left alone: the scheduler would skip
+		// it, and it will pick up this query anyway.
+		std::scoped_lock lock(search_mutex_);
+		query_ = q;
+		search_needed_.store(true, std::memory_order_release);
+		++requested_generation_;
+		if (search_started_) {
+			search_group_.cancel();
+		}
+
+		if (!search_running_ && !stopping_) {
+			search_group_.reset();
+			search_running_ = true;
+			dispatch        = true;
+		}
+	}
+	if (dispatch) {
+		search_group_.run(&SearchEngine::search_task, this);
+	}
 }
 
 [[nodiscard]] std::string SearchEngine::get_query() const
 {
-	const auto* qptr = query_.load(std::memory_order_acquire);
-	return qptr ? *qptr : std::string();
+	std::scoped_lock lock(search_mutex_);
+	return query_;
 }
 
-[[nodiscard]] std::optional<std::string> SearchEngine::get_completion() const
+bool SearchEngine::acquire_results()
 {
-	const auto* comps = completions_.load(std::memory_order_acquire);
-	if (!comps || comps->empty()) {
-		return std::nullopt;
+	if ((ready_.load(std::memory_order_relaxed) & FreshBit) == 0) {
+		return false;
 	}
+	front_ = ready_.exchange(front_, std::memory_order_acq_rel) & ~FreshBit;
+	return true;
+}
 
-	const std::string q = get_query();
-	if (q.empty()) {
-		return std::nullopt;
+[[nodiscard]] bool SearchEngine::results_current(
+        const std::string_view query) const
+{
+	std::scoped_lock lock(search_mutex_);
+	return query_ == query &&
+	       snapshots_[front_].generation == requested_generation_;
+}
+
+namespace {
+
+// The word being typed: whatever follows the last blank
+[[nodiscard]] std::string_view last_word(const std::string_view query)
+{
+	const size_t last_space = query.find_last_of(" \t");
+	return (last_space == std::string_view::npos)
+	             ? query
+	             : query.substr(last_space + 1);
+}
+
+// The token before the trailing blanks, split as Util::tokenize splits
+// text; empty unless query ends in a blank
+[[nodiscard]] std::string_view previous_word(const std::string_view query)
+{
+	const size_t end = query.find_last_not_of(" \t");
+	if (end == std::string_view::npos || end + 1 == query.size()) {
+		return {};
 	}
 
-	const size_t last_space  = q.find_last_of(" \t");
-	const std::string prefix = (last_space == std::string::npos)
-	                                 ? ""
-	                                 : q.substr(0, last_space + 1);
-	const std::string word   = (last_space == std::string::npos)
-	                                 ? q
-	                                 : (last_space + 1 < q.length()
-	                                            ? q.substr(last_space + 1)
-	                                            : "");
+	size_t begin = end + 1;
+	while (begin > 0 &&
+	       std::isalnum(static_cast<unsigned char>(query[begin - 1]))) {
+		--begin;
+	}
+	return query.substr(begin, end + 1 - begin);
+}
+
+} // namespace
 
-	if (word.empty() || comps->empty()) {
+[[nodiscard]] Completions SearchEngine::completions(
+        const std::string_view query) const
+{
+	return vocabulary_.complete(last_word(query));
+}
+
+[[nodiscard]] std::optional<std::string_view> SearchEngine::completion_word(
+        const std::string_view query) const
+{
+	const auto comps = completions(query);
+	if (comps.empty()) {
 		return std::nullopt;
 	}
 
-	std::string comp = (*comps)[0];
-	if (comp.empty()) {
+	// The trie node the word led to holds how far its completions agree
+	const auto comp = vocabulary_.term(comps.first).substr(0, comps.common);
+	if (comp.length() <= last_word(query).length()) {
 		return std::nullopt;
 	}
+	return comp;
+}
 
-	const auto lower_word = Util::to_lower(word);
-
-	// Find common prefix among all completions
-	for (size_t i = 1; i < comps->size() && !comp.empty(); ++i) {
-		const auto& cand = (*comps)[i];
-		if (cand.empty()) {
-			continue;
-		}
-
-		const auto lower_comp = Util::to_lower(comp);
-		const auto lower_cand = Util::to_lower(cand);
+bool SearchEngine::complete_query(std::string& query) const
+{
+	const auto word = completion_word(query);
+	if (!word) {
+		return false;
+	}
 
-		size_t match_len     = 0;
-		const size_t max_len = std::min(lower_comp.length(),
-		                                lower_cand.length());
-		while (match_len < max_len &&
-		       lower_comp[match_len] == lower_cand[match_len]) {
-			++match_len;
-		}
+	query.replace(query.size() - last_word(query).size(),
+	              std::string::npos,
+	              *word);
+	return true;
+}
 
-		if (match_len < comp.length()) {
-			comp.resize(match_len);
-		}
+[[nodiscard]] size_t SearchEngine::top_completions(
+        const std::string_view query,
+        const std::span<std::string_view, Vocabulary::TopCompletions> out) const
+{
+	if (!last_word(query).empty()) {
+		return vocabulary_.top(completions(query), out);
 	}
 
-	if (!comp.empty()) {
-		const auto lower_comp = Util::to_lower(comp);
-		if (lower_comp.starts_with(lower_word) &&
-		    comp.length() > word.length()) {
-			return prefix + comp;
-		}
+	const auto id = vocabulary_.find(previous_word(query));
+	if (!id) {
+		return 0;
+	}
+	const auto next    = next_words_.after(*id);
+	const size_t count = std::min(next.size(), out.size());
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = vocabulary_.term(next[i]);
 	}
-	return std::nullopt;
+	return count;
 }
 
 [[nodiscard]] const Entry& SearchEngine::get_entry(const size_t idx) const
@@ -304,14 +1008,30 @@ void SearchEngine::update_query(const std::string& q)
 	return entries_.size();
 }
 
-[[nodiscard]] std::vector<SearchResult> SearchEngine::get_results() const
+[[nodiscard]] std::span<const MatchSpan> SearchEngine::match_spans(
+        const size_t position) const
 {
-	const auto* rptr = results_.load(std::memory_order_acquire);
-	return rptr ? *rptr : std::vector<SearchResult>{};
+	const auto& snapshot = snapshots_[front_];
+	if (position + 1 >= snapshot.span_starts.size()) {
+		return {};
+	}
+	return std::span(snapshot.spans)
+	        .subspan(snapshot.span_starts[position],
+	                 snapshot.span_starts[position + 1] -
+	                         snapshot.span_starts[position]);
 }
 
-[[nodiscard]] std::vector<std::string> SearchEngine::get_completions() const
+[[nodiscard]] size_t SearchEngine::result_count() const
 {
-	const auto* cptr = completions_.load(std::memory_order_acquire);
-	return cptr ? *cptr : std::vector<std::string>{};
+	return snapshots_[front_].results.size();
+}
+
+[[nodiscard]] std::span<const SearchResult> SearchEngine::results(
+        const size_t offset, const size_t count) const
+{
+	const std::span<const SearchResult> all = snapshots_[front_].results;
+	if (offset >= all.size()) {
+		return {};
+	}
+	return all.subspan(offset, std::min(count, all.size() - offset));
 }
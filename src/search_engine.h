@@ -2,14 +2,24 @@
 #define SEARCH_ENGINE_H
 
 #include "command_t.h"
+#include "acronym_index.h"
 #include "entry_t.h"
+#include "event_loop.h"
+#include "next_words.h"
+#include "normalizer.h"
 #include "safe_queue.h"
+#include "task_scheduler.h"
+#include "vocabulary.h"
 
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <vector>
 
 // ============================================================================
@@ -21,47 +31,272 @@ struct SearchResult {
 	int score    = {};
 };
 
+enum class MatchField : uint8_t { Key, Content };
+
+// Where a query word matched, as a byte range of the entry's key or content
+struct MatchSpan {
+	uint32_t begin   = 0;
+	uint16_t length  = 0;
+	MatchField field = MatchField::Key;
+};
+
+// What one search publishes. The spans of result i are
+// spans[span_starts[i]] up to spans[span_starts[i + 1]], for the top
+// Display::HighlightedResults results only.
+struct SearchSnapshot {
+	std::vector<SearchResult> results = {};
+	std::vector<MatchSpan> spans      = {};
+	std::vector<uint32_t> span_starts = {};
+	uint64_t generation               = 0;
+};
+
 class SearchEngine {
-	std::vector<Entry> entries_                         = {};
-	std::atomic<std::vector<SearchResult>*> results_    = nullptr;
-	std::atomic<std::vector<std::string>*> completions_ = nullptr;
-	std::atomic<std::string*> query_                    = nullptr;
+	// For each entry, a bit per query word that it matches in a way
+	// found before the scan: holding a term a few edits away, having its
+	// letters in order in the key's folder name, being its acronym, or
+	// holding the word in another spelling
+	struct WordHits {
+		uint32_t similar     = 0;
+		uint32_t subsequence = 0;
+		uint32_t acronym     = 0;
+		uint32_t equivalent  = 0;
+	};
+
+	// How score() took a query word to match an entry, for
+	// highlighting: the class that won, and where the word lies in the
+	// key and in a word of the content when it matched as typed
+	enum class MatchKind : uint8_t {
+		None,
+		Literal,
+		Acronym,
+		Equivalent,
+		Similar,
+		Subsequence
+	};
+
+	struct WordMatch {
+		static constexpr uint32_t NoPosition = UINT32_MAX;
+
+		MatchKind kind   = MatchKind::None;
+		uint32_t key     = NoPosition;
+		uint32_t content = NoPosition;
+	};
+
+	// A vocabulary term, lowercased, within edits of a query word
+	struct SimilarTerm {
+		size_t word           = 0;
+		std::string_view term = {};
+	};
+
+	// Upstream of the search arena: takes from the heap what the arena's
+	// buffer can't hold, and counts it so the buffer can grow to fit
+	class ArenaSpill final : public std::pmr::memory_resource {
+		size_t bytes_ = 0;
+
+		void* do_allocate(const size_t bytes,
+		                  const size_t alignment) override;
+
+		void do_deallocate(void* p, const size_t bytes,
+		                   const size_t alignment) override;
+
+		[[nodiscard]] bool do_is_equal(
+		        const std::pmr::memory_resource& other)
+		        const noexcept override;
+
+	public:
+		// Bytes taken since the last call
+		[[nodiscard]] size_t take();
+	};
+
+	// Initial size; a search that overflows the arena grows it
+	static constexpr size_t ArenaBytes = 16 * 1024;
+	static constexpr size_t FreshBit   = 4; // set on ready_ by publish()
+
+	std::vector<Entry> entries_ = {};
+	Normalizer normalizer_      = {}; // canonical spellings and synonyms
+	Vocabulary vocabulary_      = {}; // every key and word, for completion
+	NextWords next_words_       = {}; // what follows each word in titles
+	AcronymIndex acronyms_      = {}; // initialisms of every name
+
+	// Entries each vocabulary term occurs in, in compressed rows: term
+	// t's entries end where t + 1's begin
+	std::vector<uint32_t> posting_starts_ = {};
+	std::vector<uint32_t> postings_       = {};
+
+	// The lowercased folder name ending each key, back to back, so the
+	// subsequence scan reads one column: entry i's ends where i + 1's
+	// begins
+	std::string key_column_           = {};
+	std::vector<uint32_t> key_starts_ = {};
+
 	std::atomic<bool> search_needed_{false};
-	SafeQueue<Command>* queue_ = nullptr;
+	std::string query_             = {}; // guarded by search_mutex_
+	uint64_t requested_generation_ = 0;  // guarded by search_mutex_
+	SafeQueue<Command>* queue_     = nullptr;
+	EventLoop* loop_               = nullptr;
+
+	TaskScheduler& scheduler_;
+	TaskGroup search_group_;
+	mutable std::mutex search_mutex_ = {};
+	bool search_running_             = false; // a search task is queued
+	bool search_started_             = false; // ... and has taken a query
+	bool stopping_                   = false;
+
+	// Triple buffer of published snapshots: the search fills back_, swaps
+	// it into ready_, and the UI thread swaps ready_ into front_. Each
+	// side owns its slot outright, and the vectors keep their capacity,
+	// so publishing allocates nothing once they have grown.
+	std::array<SearchSnapshot, 3> snapshots_ = {};
+	size_t front_                            = 0; // UI thread
+	size_t back_                             = 1; // search task
+	std::atomic<size_t> ready_{2};
 
+	// Search-task scratch. Query-sized temporaries come from the arena,
+	// which is released after every search and grown to the largest one
+	// seen; the per-chunk hits of the parallel scan keep their capacity
+	// between searches.
+	std::string search_query_                             = {};
+	ArenaSpill arena_spill_                               = {};
+	std::vector<std::byte> arena_buffer_                  = {};
+	std::pmr::monotonic_buffer_resource arena_;
+	std::vector<std::vector<SearchResult>> chunk_results_ = {};
+
+	// Terms close to a query word, and what each entry matched before
+	// the scan
+	std::vector<uint32_t> similar_terms_ = {};
+	std::vector<WordHits> word_hits_     = {};
+
+	// Parts of an entry's text found to spell a query word another way
+	std::vector<std::string_view> pieces_ = {};
+
+	// True if the words occur in text in order; with at_word_starts, each
+	// must also begin a word of text
 	[[nodiscard]] static bool has_sequential_match(
 	        const std::string_view text,
-	        const std::vector<std::string_view>& words);
+	        const std::span<const std::string_view> words,
+	        const bool at_word_starts = false);
 
-	[[nodiscard]] int score(const Entry& entry, const std::string_view query) const;
+	// An acronym hit outranks a key substring, and adds to a folder name
+	// or whole word spelled the same; an equivalent hit ranks with a word
+	// prefix; a similar or subsequence hit only scores when the word
+	// matches nothing as typed.
+	// Words found in order earn a sequential bonus, larger when each
+	// starts a word; the canonical query words count in the canonical
+	// content too. Given one match per word, records how each matched.
+	[[nodiscard]] static int score(
+	        const Entry& entry,
+	        const std::span<const std::string_view> words,
+	        const std::span<const std::string_view> canonical,
+	        const WordHits& hits,
+	        const std::span<WordMatch> matches = {});
 
-	[[nodiscard]] std::vector<std::string> find_completions(
-	        const std::string_view query) const;
+	// Sets the subsequence bits with one pass over key_column_ per query
+	// word
+	void find_subsequences(const std::span<const std::string_view> words);
+
+	// Sets the acronym bits of the entries each query word is an
+	// initialism of
+	void find_acronyms(const std::span<const std::string_view> words);
+
+	// Sets the equivalent bits of the entries indexed under each canonical
+	// query word, or under a synonym phrase a run of them spells
+	void find_equivalents(
+	        const std::span<const std::string_view> canonical);
+
+	// Sets the similar bits of the entries holding terms close to each
+	// query word, and appends those terms to similar
+	void find_similar(const std::span<const std::string_view> words,
+	                  std::pmr::vector<SimilarTerm>& similar);
+
+	[[nodiscard]] std::span<const uint32_t> postings(
+	        const uint32_t term) const;
+
+	// Appends where each word matched as score() recorded it: the text
+	// it matched as typed, the initials or other spelling it stands for,
+	// the folder name letters it abbreviates, or the word it was taken
+	// to be a typo of. Sorted, with overlaps merged.
+	void collect_spans(const Entry& entry,
+	                   const std::span<const std::string_view> words,
+	                   const std::span<const std::string_view> canonical,
+	                   const std::span<const WordMatch> matches,
+	                   const std::span<const SimilarTerm> similar,
+	                   std::vector<MatchSpan>& spans);
+
+	static void search_task(void* context);
 
-	void search_worker(std::atomic<bool>& stop_flag);
+	// Rebuilds the arena over a buffer of the given size
+	void grow_arena(const size_t bytes);
+
+	void run_searches();
+
+	void publish();
 
 public:
-	explicit SearchEngine(std::vector<Entry> entries);
+	// The normalizer's canonical words and synonyms are indexed with the
+	// words of each entry
+	SearchEngine(std::vector<Entry> entries, TaskScheduler& scheduler,
+	             Normalizer normalizer = {});
 
 	~SearchEngine();
 
-	void set_queue(SafeQueue<Command>* q);
+	// Search completions are queued as RefreshDisplay and announced by
+	// waking the loop
+	void set_queue(SafeQueue<Command>* q, EventLoop* loop);
 
-	[[nodiscard]] std::thread start(std::atomic<bool>& stop_flag);
+	// Cancels a running search and waits for the pool to let go of it
+	void stop();
 
 	void update_query(const std::string& q);
 
 	[[nodiscard]] std::string get_query() const;
 
-	[[nodiscard]] std::optional<std::string> get_completion() const;
+	// UI thread: switches to the newest published snapshot; true if there
+	// was one
+	bool acquire_results();
+
+	// True once the snapshot for the latest update_query() is acquired
+	// and that query was the given one
+	[[nodiscard]] bool results_current(const std::string_view query) const;
+
+	// Completion doesn't wait for searches: these look the last word of
+	// query up in the vocabulary, which never changes once built, so any
+	// thread may call them for the query as typed. Views returned point
+	// into the vocabulary.
+	[[nodiscard]] Completions completions(
+	        const std::string_view query) const;
+
+	// The common prefix of the completions, if it extends the last word
+	[[nodiscard]] std::optional<std::string_view> completion_word(
+	        const std::string_view query) const;
+
+	// Replaces the last word of query with completion_word(); false if
+	// there was nothing to complete
+	bool complete_query(std::string& query) const;
+
+	// The most frequent completions of the last word of query, best
+	// first; returns how many. After a blank, the words that most often
+	// follow the previous one in titles instead.
+	[[nodiscard]] size_t top_completions(
+	        const std::string_view query,
+	        const std::span<std::string_view, Vocabulary::TopCompletions>
+	                out) const;
 
 	[[nodiscard]] const Entry& get_entry(const size_t idx) const;
 
 	[[nodiscard]] size_t get_entry_count() const;
 
-	[[nodiscard]] std::vector<SearchResult> get_results() const;
+	// Number of results in the acquired snapshot
+	[[nodiscard]] size_t result_count() const;
+
+	// Up to count results from offset on, clamped to the snapshot; valid
+	// until the next acquire_results()
+	[[nodiscard]] std::span<const SearchResult> results(
+	        const size_t offset, const size_t count) const;
 
-	[[nodiscard]] std::vector<std::string> get_completions() const;
+	// Match spans of the result at position, empty past the highlighted
+	// top rows
+	[[nodiscard]] std::span<const MatchSpan> match_spans(
+	        const size_t position) const;
 };
 
 #endif
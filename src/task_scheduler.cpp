@@ -0,0 +1,312 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+namespace {
+
+constexpr size_t NotAWorker = static_cast<size_t>(-1);
+
+// Index of the worker running on this thread, so nested submissions land
+// on the local deque
+thread_local size_t current_worker = NotAWorker;
+thread_local const TaskScheduler* current_scheduler = nullptr;
+
+} // namespace
+
+// ============================================================================
+// Task Scheduler
+// ============================================================================
+
+void TaskScheduler::RangeJob::run_chunks()
+{
+	while (!group || !group->is_cancelled()) {
+		const size_t chunk = next.fetch_add(grain,
+		                                    std::memory_order_relaxed);
+		if (chunk >= end) {
+			break;
+		}
+		body(fn, chunk, std::min(chunk + grain, end));
+	}
+}
+
+void TaskScheduler::RangeJob::run_helper(void* context)
+{
+	auto& job = *static_cast<RangeJob*>(context);
+	job.run_chunks();
+
+	// The job lives on the waiting thread's stack; don't touch it after
+	// the last decrement
+	auto* scheduler = job.scheduler;
+	if (job.outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		scheduler->signal_done();
+	}
+}
+
+void TaskScheduler::worker_loop(const size_t index)
+{
+	current_worker    = index;
+	current_scheduler = this;
+
+#ifndef _WIN32
+	// Signals are the event loop's to handle; the pool may be started
+	// before it blocks them
+	sigset_t mask = {};
+	sigfillset(&mask);
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+#endif
+
+	while (true) {
+		if (auto task = pop(index)) {
+			execute(*task);
+			continue;
+		}
+		if (auto task = steal(index)) {
+			execute(*task);
+			continue;
+		}
+
+		std::unique_lock lock(sleep_mutex_);
+		wake_cv_.wait(lock, [this] {
+			return stopping_ ||
+			       queued_.load(std::memory_order_acquire) > 0;
+		});
+		if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+	}
+}
+
+void TaskScheduler::signal_done()
+{
+	{
+		std::scoped_lock lock(done_mutex_);
+	}
+	done_cv_.notify_all();
+}
+
+void TaskScheduler::help_until_zero(const std::atomic<size_t>& count)
+{
+	while (count.load(std::memory_order_acquire) > 0) {
+		if (run_one()) {
+			continue;
+		}
+		std::unique_lock lock(done_mutex_);
+		done_cv_.wait(lock, [&count] {
+			return count.load(std::memory_order_acquire) == 0;
+		});
+	}
+}
+
+[[nodiscard]] std::optional<Task> TaskScheduler::pop(const size_t index)
+{
+	auto& worker = *workers_[index];
+
+	std::scoped_lock lock(worker.mutex);
+	if (worker.head == worker.tail) {
+		return std::nullopt;
+	}
+	--worker.tail;
+	queued_.fetch_sub(1, std::memory_order_acq_rel);
+	return worker.ring[worker.tail % DequeCapacity];
+}
+
+[[nodiscard]] std::optional<Task> TaskScheduler::steal(const size_t index)
+{
+	const size_t count = workers_.size();
+	const size_t start = (index == NotAWorker) ? 0 : index + 1;
+
+	for (size_t i = 0; i < count; ++i) {
+		auto& victim = *workers_[(start + i) % count];
+
+		std::scoped_lock lock(victim.mutex);
+		if (victim.head != victim.tail) {
+			const Task task =
+			        victim.ring[victim.head % DequeCapacity];
+			++victim.head;
+			queued_.fetch_sub(1, std::memory_order_acq_rel);
+			return task;
+		}
+	}
+	return std::nullopt;
+}
+
+void TaskScheduler::run_range(RangeJob& job)
+{
+	const size_t first  = job.next.load(std::memory_order_relaxed);
+	const size_t span   = (job.end > first) ? (job.end - first) : 0;
+	const size_t chunks = (span + job.grain - 1) / job.grain;
+
+	const size_t helpers = std::min(chunks > 0 ? chunks - 1 : 0,
+	                                workers_.size());
+
+	job.outstanding.store(helpers, std::memory_order_relaxed);
+	for (size_t i = 0; i < helpers; ++i) {
+		submit({&RangeJob::run_helper, &job, nullptr});
+	}
+
+	job.run_chunks();
+
+	// Helpers that never got a worker are run here; they find no chunks
+	// left and only sign off
+	help_until_zero(job.outstanding);
+}
+
+TaskScheduler::TaskScheduler(size_t workers)
+{
+	if (workers == 0) {
+		const size_t hardware = std::thread::hardware_concurrency();
+		workers = std::max<size_t>(hardware > 1 ? hardware - 1 : 1, 1);
+	}
+
+	workers_.reserve(workers);
+	for (size_t i = 0; i < workers; ++i) {
+		workers_.emplace_back(std::make_unique<Worker>());
+	}
+
+	threads_.reserve(workers);
+	for (size_t i = 0; i < workers; ++i) {
+		threads_.emplace_back([this, i]() { worker_loop(i); });
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::scoped_lock lock(sleep_mutex_);
+		stopping_ = true;
+	}
+	wake_cv_.notify_all();
+
+	for (auto& thread : threads_) {
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+}
+
+[[nodiscard]] size_t TaskScheduler::worker_count() const
+{
+	return workers_.size();
+}
+
+void TaskScheduler::submit(const Task& task)
+{
+	const bool local = (current_scheduler == this &&
+	                    current_worker != NotAWorker);
+	const size_t count = workers_.size();
+	const size_t first = local ? current_worker
+	                           : next_victim_.fetch_add(1) % count;
+
+	for (size_t i = 0; i < count; ++i) {
+		auto& worker = *workers_[(first + i) % count];
+
+		std::unique_lock lock(worker.mutex);
+		if (worker.tail - worker.head == DequeCapacity) {
+			continue;
+		}
+		worker.ring[worker.tail % DequeCapacity] = task;
+		++worker.tail;
+		queued_.fetch_add(1, std::memory_order_acq_rel);
+		lock.unlock();
+
+		{
+			std::scoped_lock sleep_lock(sleep_mutex_);
+		}
+		wake_cv_.notify_one();
+		return;
+	}
+
+	execute(task);
+}
+
+bool TaskScheduler::run_one()
+{
+	const bool local = (current_scheduler == this &&
+	                    current_worker != NotAWorker);
+
+	std::optional<Task> task = local ? pop(current_worker) : std::nullopt;
+	if (!task) {
+		task = steal(local ? current_worker : NotAWorker);
+	}
+	if (!task) {
+		return false;
+	}
+	execute(*task);
+	return true;
+}
+
+void TaskScheduler::execute(const Task& task)
+{
+	using namespace std::string_view_literals;
+
+	if (!task.group || !task.group->is_cancelled()) {
+		try {
+			task.fn(task.context);
+		} catch (const std::exception& e) {
+			std::cerr << "Task error: "sv << e.what() << '\n';
+		} catch (...) {
+			std::cerr << "Unknown task error\n"sv;
+		}
+	}
+
+	if (task.group) {
+		task.group->finish_one();
+	}
+}
+
+// ============================================================================
+// Task Group
+// ============================================================================
+
+void TaskGroup::finish_one()
+{
+	// The group may be destroyed as soon as the count reaches zero
+	auto& scheduler = scheduler_;
+	if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		scheduler.signal_done();
+	}
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler) : scheduler_(scheduler) {}
+
+TaskGroup::~TaskGroup()
+{
+	cancel();
+	wait();
+}
+
+void TaskGroup::run(void (*fn)(void*), void* context)
+{
+	pending_.fetch_add(1, std::memory_order_acq_rel);
+	scheduler_.submit({fn, context, this});
+}
+
+void TaskGroup::cancel()
+{
+	cancelled_.store(true, std::memory_order_release);
+}
+
+void TaskGroup::reset()
+{
+	cancelled_.store(false, std::memory_order_release);
+}
+
+[[nodiscard]] bool TaskGroup::is_cancelled() const
+{
+	return cancelled_.load(std::memory_order_acquire);
+}
+
+void TaskGroup::wait()
+{
+	scheduler_.help_until_zero(pending_);
+}
+
+[[nodiscard]] TaskScheduler& TaskGroup::scheduler() const
+{
+	return scheduler_;
+}
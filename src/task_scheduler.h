@@ -0,0 +1,175 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ============================================================================
+// Task Scheduler
+// ============================================================================
+
+class TaskGroup;
+
+// A unit of work: a plain function and its context, so queueing a task
+// never allocates. The group, if any, is told when the task finishes.
+struct Task {
+	void (*fn)(void*) = nullptr;
+	void* context     = nullptr;
+	TaskGroup* group  = nullptr;
+};
+
+// Work-stealing pool shared by loading, indexing and search. Each worker
+// pops from the back of its own deque and steals from the front of the
+// others'. Threads that wait for work (parallel_for, TaskGroup::wait)
+// run queued tasks while they wait, so nested waits cannot deadlock.
+class TaskScheduler {
+	static constexpr size_t DequeCapacity = 256;
+
+	struct alignas(64) Worker {
+		std::mutex mutex                     = {};
+		std::array<Task, DequeCapacity> ring = {};
+		size_t head                          = 0; // steal end
+		size_t tail                          = 0; // owner end
+	};
+
+	// Shared state of one parallel_for; lives on the caller's stack
+	struct RangeJob {
+		void (*body)(void*, size_t, size_t) = nullptr;
+		void* fn                            = nullptr;
+		size_t end                          = 0;
+		size_t grain                        = 1;
+		const TaskGroup* group              = nullptr;
+		TaskScheduler* scheduler            = nullptr;
+		std::atomic<size_t> next{0};
+		std::atomic<size_t> outstanding{0};
+
+		void run_chunks();
+
+		static void run_helper(void* context);
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers_ = {};
+	std::vector<std::thread> threads_             = {};
+	std::atomic<size_t> queued_{0};
+	std::atomic<size_t> next_victim_{0};
+	std::mutex sleep_mutex_          = {};
+	std::condition_variable wake_cv_ = {};
+	bool stopping_                   = false;
+
+	// Completion of jobs and groups is announced here rather than on
+	// their own atomics, which the waiter may free as soon as it sees
+	// the final count
+	std::mutex done_mutex_           = {};
+	std::condition_variable done_cv_ = {};
+
+	friend class TaskGroup;
+
+	void worker_loop(const size_t index);
+
+	void signal_done();
+
+	// Runs queued tasks until count reaches zero, sleeping when there is
+	// nothing to help with
+	void help_until_zero(const std::atomic<size_t>& count);
+
+	[[nodiscard]] std::optional<Task> pop(const size_t index);
+
+	[[nodiscard]] std::optional<Task> steal(const size_t index);
+
+	void run_range(RangeJob& job);
+
+public:
+	// Zero picks one worker per hardware thread, less the calling one
+	explicit TaskScheduler(size_t workers = 0);
+
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler&)            = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	[[nodiscard]] size_t worker_count() const;
+
+	// Queues on the calling worker's deque, or round-robin from other
+	// threads. A task that finds every deque full runs inline.
+	void submit(const Task& task);
+
+	// Runs one queued task if there is any
+	bool run_one();
+
+	// Runs the task unless its group was cancelled while it was queued
+	static void execute(const Task& task);
+
+	// Calls fn(chunk_begin, chunk_end) for consecutive chunks of at most
+	// grain indices, spread over the workers and the calling thread.
+	// Returns once every chunk ran, or early once group is cancelled.
+	template <typename F>
+	void parallel_for(const size_t begin, const size_t end,
+	                  const size_t grain, F&& fn,
+	                  const TaskGroup* group = nullptr)
+	{
+		using Fn = std::remove_reference_t<F>;
+
+		RangeJob job = {};
+		job.body = [](void* f, const size_t b, const size_t e) {
+			(*static_cast<Fn*>(f))(b, e);
+		};
+		job.fn    = const_cast<void*>(static_cast<const void*>(&fn));
+		job.end   = end;
+		job.grain = (grain == 0) ? 1 : grain;
+		job.group = group;
+		job.scheduler = this;
+		job.next.store(begin, std::memory_order_relaxed);
+		run_range(job);
+	}
+};
+
+// ============================================================================
+// Task Group
+// ============================================================================
+
+// Tracks a set of tasks so they can be waited on or cancelled together.
+// Cancellation is cooperative: queued tasks are skipped and running ones
+// poll is_cancelled().
+class TaskGroup {
+	TaskScheduler& scheduler_;
+	std::atomic<size_t> pending_{0};
+	std::atomic<bool> cancelled_{false};
+
+	friend class TaskScheduler;
+
+	void finish_one();
+
+public:
+	explicit TaskGroup(TaskScheduler& scheduler);
+
+	// Cancels and waits for anything still queued or running
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&)            = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	// Queues fn(context) on the pool; it is skipped, though still
+	// counted as finished, if the group is cancelled before it starts
+	void run(void (*fn)(void*), void* context);
+
+	void cancel();
+
+	// Clears a previous cancel() so the group can be reused
+	void reset();
+
+	[[nodiscard]] bool is_cancelled() const;
+
+	// Helps run queued tasks until every task in the group has finished
+	void wait();
+
+	[[nodiscard]] TaskScheduler& scheduler() const;
+};
+
+#endif
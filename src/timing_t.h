@@ -7,11 +7,10 @@ namespace Timing {
 
 using namespace std::chrono_literals;
 
-constexpr auto SearchSleep           = 30ms;
-constexpr auto IOSleep               = 50ms;
-constexpr auto HeightCache           = 500ms;
-constexpr auto InputTimeout          = 10ms;
-constexpr auto IntraCharacterTimeout = 1ms;
+constexpr auto SearchDebounce = 5ms;
+constexpr auto EscapeTimeout  = 25ms;
+constexpr auto FrameInterval  = 16ms; // default; EDS_FRAME_MS overrides
+constexpr auto SlowWrite      = 20ms; // a frame write this long degrades
 } // namespace Timing
 
 #endif
@@ -0,0 +1,161 @@
+#include "unicode.h"
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+
+// ============================================================================
+// Unicode
+// ============================================================================
+
+namespace {
+
+struct Range {
+	char32_t first = 0;
+	char32_t last  = 0;
+};
+
+// Combining marks, joiners and variation selectors
+constexpr std::array ZeroWidth = {
+        Range{0x0300, 0x036F},
+        Range{0x0483, 0x0489},
+        Range{0x0591, 0x05BD},
+        Range{0x0610, 0x061A},
+        Range{0x064B, 0x065F},
+        Range{0x0E31, 0x0E31},
+        Range{0x0E34, 0x0E3A},
+        Range{0x0E47, 0x0E4E},
+        Range{0x1AB0, 0x1AFF},
+        Range{0x1DC0, 0x1DFF},
+        Range{0x200B, 0x200F},
+        Range{0x20D0, 0x20FF},
+        Range{0xFE00, 0xFE0F},
+        Range{0xFE20, 0xFE2F},
+        Range{0xFEFF, 0xFEFF},
+        Range{0xE0100, 0xE01EF},
+};
+
+// East Asian Wide and Fullwidth, and emoji presentation blocks
+constexpr std::array Wide = {
+        Range{0x1100, 0x115F},
+        Range{0x2E80, 0x303E},
+        Range{0x3041, 0x33FF},
+        Range{0x3400, 0x4DBF},
+        Range{0x4E00, 0x9FFF},
+        Range{0xA000, 0xA4CF},
+        Range{0xAC00, 0xD7A3},
+        Range{0xF900, 0xFAFF},
+        Range{0xFE30, 0xFE4F},
+        Range{0xFF00, 0xFF60},
+        Range{0xFFE0, 0xFFE6},
+        Range{0x1F300, 0x1F64F},
+        Range{0x1F900, 0x1F9FF},
+        Range{0x20000, 0x2FFFD},
+        Range{0x30000, 0x3FFFD},
+};
+
+constexpr char32_t ZeroWidthJoiner = 0x200D;
+constexpr char32_t Replacement     = 0xFFFD;
+
+template <size_t N>
+[[nodiscard]] bool in_ranges(const std::array<Range, N>& ranges,
+                             const char32_t cp)
+{
+	const auto it = std::ranges::upper_bound(ranges, cp, {}, &Range::first);
+	return it != ranges.begin() && cp <= std::prev(it)->last;
+}
+
+// Decodes the code point at pos and advances past it; malformed input
+// decodes one byte at a time as U+FFFD
+[[nodiscard]] char32_t decode(const std::string_view text, size_t& pos)
+{
+	const auto lead = static_cast<unsigned char>(text[pos]);
+	if (lead < 0x80) {
+		++pos;
+		return lead;
+	}
+
+	const size_t length = (lead >= 0xF0)   ? 4
+	                      : (lead >= 0xE0) ? 3
+	                      : (lead >= 0xC0) ? 2
+	                                       : 0;
+	if (length == 0 || pos + length > text.size()) {
+		++pos;
+		return Replacement;
+	}
+
+	char32_t cp = lead & (0x7F >> length);
+	for (size_t i = 1; i < length; ++i) {
+		const auto c = static_cast<unsigned char>(text[pos + i]);
+		if ((c & 0xC0) != 0x80) {
+			++pos;
+			return Replacement;
+		}
+		cp = (cp << 6) | (c & 0x3F);
+	}
+	pos += length;
+	return cp;
+}
+
+} // namespace
+
+namespace Unicode {
+
+[[nodiscard]] int code_point_width(const char32_t cp)
+{
+	if (cp < 0x300) {
+		return 1;
+	}
+	if (cp == ZeroWidthJoiner || in_ranges(ZeroWidth, cp)) {
+		return 0;
+	}
+	return in_ranges(Wide, cp) ? 2 : 1;
+}
+
+[[nodiscard]] size_t measure(const std::string_view text,
+                             std::vector<ClusterStop>& stops)
+{
+	if (std::ranges::all_of(text, [](const char c) {
+		    return static_cast<unsigned char>(c) < 0x80;
+	    })) {
+		return text.size();
+	}
+
+	size_t width = 0;
+	bool joined  = false; // the previous code point was a ZWJ
+
+	for (size_t pos = 0; pos < text.size();) {
+		const char32_t cp = decode(text, pos);
+		const int cp_width = code_point_width(cp);
+
+		// Zero-width code points and anything after a joiner extend
+		// the current cluster
+		if (!stops.empty() && (cp_width == 0 || joined)) {
+			stops.back().end = static_cast<uint32_t>(pos);
+		} else {
+			width += static_cast<size_t>(cp_width);
+			stops.push_back({static_cast<uint32_t>(pos),
+			                 static_cast<uint32_t>(width)});
+		}
+		joined = (cp == ZeroWidthJoiner);
+	}
+	return width;
+}
+
+[[nodiscard]] size_t fit(const std::string_view text,
+                         const std::vector<ClusterStop>& stops,
+                         const size_t columns)
+{
+	if (stops.empty()) {
+		return std::min(text.size(), columns);
+	}
+
+	// Last cluster that ends within the columns
+	const auto width = [](const ClusterStop& stop) {
+		return static_cast<size_t>(stop.width);
+	};
+	const auto it = std::ranges::upper_bound(stops, columns, {}, width);
+	return (it == stops.begin()) ? 0 : std::prev(it)->end;
+}
+
+} // namespace Unicode
@@ -0,0 +1,41 @@
+#ifndef UNICODE_H
+#define UNICODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Unicode
+// ============================================================================
+
+namespace Unicode {
+
+// End of a grapheme cluster: its byte offset past the cluster and the
+// display width of the text up to there
+struct ClusterStop {
+	uint32_t end   = 0;
+	uint32_t width = 0;
+};
+
+// Terminal columns of one code point: 0 for combining marks and joiners,
+// 2 for East Asian wide and emoji, 1 otherwise
+[[nodiscard]] int code_point_width(const char32_t cp);
+
+// Returns the display width of UTF-8 text. Unless every byte is ASCII,
+// which is one column each, also appends a stop after every cluster.
+// Clusters are approximated as a base code point plus the zero-width
+// marks and joined code points that follow it.
+[[nodiscard]] size_t measure(const std::string_view text,
+                             std::vector<ClusterStop>& stops);
+
+// Bytes of text that fit in columns without splitting a cluster, given
+// the stops measure() produced for it
+[[nodiscard]] size_t fit(const std::string_view text,
+                         const std::vector<ClusterStop>& stops,
+                         const size_t columns);
+
+} // namespace Unicode
+
+#endif
@@ -1,6 +1,7 @@
 #include "utilities.h"
 
 #include <algorithm>
+#include <array>
 #include <ranges>
 #include <sstream>
 #include <string> // if std::string used here
@@ -10,6 +11,8 @@
 #include <conio.h>
 #include <windows.h>
 #else
+#include <cerrno>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <termios.h>
@@ -31,10 +34,11 @@ namespace Util {
     });
     return result;
 }
-[[nodiscard]] std::vector<std::string_view> tokenize(const std::string_view text)
-{
-	std::vector<std::string_view> words = {};
+namespace {
 
+template <typename Words>
+void append_tokens(const std::string_view text, Words& words)
+{
 	const char* data = text.data();
 	const size_t len = text.size();
 
@@ -59,19 +63,54 @@ namespace Util {
 		// Add the token as a string_view pointing into content
 		words.emplace_back(data + start, i - start);
 	}
+}
+
+} // namespace
+
+[[nodiscard]] std::vector<std::string_view> tokenize(
+        const std::string_view text)
+{
+	std::vector<std::string_view> words = {};
+	append_tokens(text, words);
 	return words;
 }
 
-[[nodiscard]] size_t terminal_height()
+void tokenize(const std::string_view text,
+              std::pmr::vector<std::string_view>& words)
+{
+	append_tokens(text, words);
+}
+
+[[nodiscard]] TerminalSize terminal_size()
 {
 #ifdef _WIN32
 	CONSOLE_SCREEN_BUFFER_INFO csbi = {};
-	GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
-	return csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+	const HANDLE out                = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (!GetConsoleScreenBufferInfo(out, &csbi)) {
+		return {};
+	}
+	const auto& window = csbi.srWindow;
+	return {static_cast<size_t>(window.Bottom - window.Top + 1),
+	        static_cast<size_t>(window.Right - window.Left + 1)};
 #else
 	winsize w = {};
-	ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-	return w.ws_row;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) < 0) {
+		return {};
+	}
+	return {w.ws_row, w.ws_col};
+#endif
+}
+
+[[nodiscard]] size_t output_backlog()
+{
+#if defined(_WIN32) || !defined(TIOCOUTQ)
+	return 0;
+#else
+	int queued = 0;
+	if (ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) < 0 || queued < 0) {
+		return 0;
+	}
+	return static_cast<size_t>(queued);
 #endif
 }
 
@@ -146,4 +185,136 @@ void clear_to_end_of_screen()
 #endif
 }
 
+#ifndef _WIN32
+namespace {
+
+// Replies to the probe are private CSI sequences; anything else read
+// meanwhile was typed
+struct ProbeReplies {
+	bool supported = false;
+	bool answered  = false;
+};
+
+// Takes the complete replies off the front of pending and moves the
+// bytes around them to typed. A partial reply is left for the next read.
+void take_replies(std::string& pending, std::string& typed,
+                  ProbeReplies& replies)
+{
+	using namespace std::string_view_literals;
+
+	constexpr auto Reply  = "\033[?"sv;
+	constexpr auto Report = "\033[?2026;"sv; // then Ps $ y
+
+	const std::string_view text = pending;
+	size_t pos                  = 0;
+	while (pos < text.size()) {
+		const auto rest = text.substr(pos);
+		if (!Reply.starts_with(rest.substr(0, Reply.size()))) {
+			typed += rest.front();
+			++pos;
+			continue;
+		}
+		const auto final_byte = std::ranges::find_if(
+		        rest.substr(std::min(rest.size(), Reply.size())),
+		        [](const char c) { return c >= '@' && c <= '~'; });
+		if (final_byte == rest.end()) {
+			break;
+		}
+		const auto reply = rest.substr(
+		        0, static_cast<size_t>(final_byte - rest.begin()) + 1);
+		pos += reply.size();
+
+		// Ps 1 to 3 mean the mode is known; DA1 always comes last
+		if (reply.ends_with("$y"sv) && reply.starts_with(Report)) {
+			const char state = reply[Report.size()];
+			replies.supported = state >= '1' && state <= '3';
+		} else if (reply.back() == 'c') {
+			replies.answered = true;
+		}
+	}
+	pending.erase(0, pos);
+}
+
+} // namespace
+#endif
+
+[[nodiscard]] bool supports_synchronized_output(std::string& typed)
+{
+#ifdef _WIN32
+	return false;
+#else
+	using namespace std::string_view_literals;
+
+	if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+		return false;
+	}
+
+	// DECRQM for mode 2026, then primary device attributes. Every
+	// terminal answers the latter, so its reply ends the wait even when
+	// the mode query is ignored.
+	write_stdout("\033[?2026$p\033[c"sv);
+
+	constexpr int TimeoutMs = 200;
+
+	std::array<char, 256> chunk = {};
+	std::string pending         = {};
+	ProbeReplies replies        = {};
+
+	while (!replies.answered) {
+		pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+		if (poll(&pfd, 1, TimeoutMs) <= 0) {
+			break;
+		}
+		const ssize_t n = read(STDIN_FILENO,
+		                       chunk.data(),
+		                       chunk.size());
+		if (n <= 0) {
+			break;
+		}
+		pending.append(chunk.data(), static_cast<size_t>(n));
+		take_replies(pending, typed, replies);
+	}
+
+	// Whatever never completed a reply was typed too
+	typed += pending;
+	return replies.supported;
+#endif
+}
+
+void write_stdout(const std::string_view text)
+{
+	std::cout.flush();
+
+#ifdef _WIN32
+	const HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+	size_t written   = 0;
+	while (written < text.size()) {
+		DWORD n = 0;
+		if (!WriteFile(out,
+		               text.data() + written,
+		               static_cast<DWORD>(text.size() - written),
+		               &n,
+		               nullptr)) {
+			return;
+		}
+		written += n;
+	}
+#else
+	size_t written = 0;
+	while (written < text.size()) {
+		const ssize_t n = write(STDOUT_FILENO,
+		                        text.data() + written,
+		                        text.size() - written);
+		if (n >= 0) {
+			written += static_cast<size_t>(n);
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			pollfd pfd = {STDOUT_FILENO, POLLOUT, 0};
+			poll(&pfd, 1, -1);
+		} else if (errno != EINTR) {
+			return;
+		}
+	}
+#endif
+}
+
 } // namespace Util
@@ -2,6 +2,7 @@
 #define UTILITIES_H
 
 #include <iostream>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -14,9 +15,24 @@ namespace Util {
 
 [[nodiscard]] std::string to_lower(const std::string_view s);
 
-[[nodiscard]] std::vector<std::string_view> tokenize(const std::string_view text);
+[[nodiscard]] std::vector<std::string_view> tokenize(
+        const std::string_view text);
 
-[[nodiscard]] size_t terminal_height();
+// Appends to words, for callers that keep tokens in an arena
+void tokenize(const std::string_view text,
+              std::pmr::vector<std::string_view>& words);
+
+// Zero when stdout isn't a terminal
+struct TerminalSize {
+	size_t rows = 0;
+	size_t cols = 0;
+};
+
+[[nodiscard]] TerminalSize terminal_size();
+
+// Bytes written to the terminal that it hasn't consumed yet (TIOCOUTQ);
+// zero where that can't be told
+[[nodiscard]] size_t output_backlog();
 
 [[nodiscard]] std::pair<size_t, size_t> get_cursor_position();
 
@@ -26,6 +42,17 @@ void clear_screen();
 
 void clear_to_end_of_screen();
 
+// Asks the terminal whether it supports synchronized output (DEC mode
+// 2026). Needs raw input; answers that arrive late count as no. Bytes
+// read meanwhile that are not part of an answer, such as keys typed at
+// startup, are appended to typed.
+[[nodiscard]] bool supports_synchronized_output(std::string& typed);
+
+// Writes all of text straight to stdout, bypassing std::cout (which is
+// flushed first to keep the order). Waits out EINTR and, on nonblocking
+// stdout, EAGAIN.
+void write_stdout(const std::string_view text);
+
 } // namespace Util
 
 #endif
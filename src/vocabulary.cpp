@@ -0,0 +1,396 @@
+#include "vocabulary.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <span>
+
+// ============================================================================
+// Vocabulary
+// ============================================================================
+
+namespace {
+
+[[nodiscard]] char fold(const char c)
+{
+	return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+[[nodiscard]] bool less_folded(const std::string_view a,
+                               const std::string_view b)
+{
+	return std::ranges::lexicographical_compare(a, b, {}, fold, fold);
+}
+
+[[nodiscard]] bool equal_folded(const std::string_view a,
+                                const std::string_view b)
+{
+	return std::ranges::equal(a, b, {}, fold, fold);
+}
+
+// Length of the prefix a and b share, ignoring case
+[[nodiscard]] uint16_t common_length(const std::string_view a,
+                                     const std::string_view b)
+{
+	const size_t limit = std::min(a.size(), b.size());
+	size_t length      = 0;
+	while (length < limit && fold(a[length]) == fold(b[length])) {
+		++length;
+	}
+	return static_cast<uint16_t>(length);
+}
+
+} // namespace
+
+Vocabulary::Vocabulary(std::vector<std::string_view> terms)
+{
+	std::erase_if(terms, [](const std::string_view t) {
+		return t.empty() || t.size() > MaxTermLength;
+	});
+
+	// Stable, so of terms that differ only in case the first one is kept
+	std::ranges::stable_sort(terms, less_folded);
+
+	size_t unique = 0;
+	for (size_t i = 0; i < terms.size();) {
+		size_t j = i + 1;
+		while (j < terms.size() && equal_folded(terms[i], terms[j])) {
+			++j;
+		}
+		terms[unique++] = terms[i];
+		frequency_.push_back(static_cast<uint32_t>(j - i));
+		i = j;
+	}
+	terms.resize(unique);
+
+	size_t bytes = 0;
+	for (const auto t : terms) {
+		bytes += t.size();
+	}
+	text_.reserve(bytes);
+	offsets_.reserve(terms.size() + 1);
+	for (const auto t : terms) {
+		offsets_.push_back(static_cast<uint32_t>(text_.size()));
+		text_.append(t);
+	}
+	offsets_.push_back(static_cast<uint32_t>(text_.size()));
+
+	if (terms.empty()) {
+		return;
+	}
+
+	// Sorted runs share the prefix their first and last terms share.
+	// A radix trie has fewer than two nodes per term.
+	const auto count = static_cast<uint32_t>(terms.size());
+	std::vector<uint32_t> ends = {count};
+	ends.reserve(2 * terms.size());
+	nodes_.reserve(2 * terms.size() + 1);
+
+	const uint16_t root_depth = common_length(term(0), term(count - 1));
+	nodes_.push_back({0, 0, root_depth, root_depth});
+
+	for (size_t n = 0; n < nodes_.size(); ++n) {
+		const Node node  = nodes_[n];
+		const size_t end = ends[n];
+		size_t i         = node.first_term;
+
+		// A term the node spells in full sorts first and ends here
+		const bool spells_term = (term(i).size() == node.depth);
+		if (spells_term) {
+			++i;
+		}
+
+		const auto first_child = static_cast<uint32_t>(nodes_.size());
+		while (i < end) {
+			const char c = fold(term(i)[node.depth]);
+			size_t j     = i + 1;
+			while (j < end && fold(term(j)[node.depth]) == c) {
+				++j;
+			}
+			const auto first     = static_cast<uint32_t>(i);
+			const uint16_t depth = common_length(term(i),
+			                                     term(j - 1));
+			nodes_.push_back({first, 0, depth, depth});
+			ends.push_back(static_cast<uint32_t>(j));
+			i = j;
+		}
+
+		nodes_[n].first_child = first_child;
+		if (spells_term && nodes_.size() == first_child + 1) {
+			nodes_[n].hint = nodes_[first_child].depth;
+		}
+	}
+
+	const auto node_count = static_cast<uint32_t>(nodes_.size());
+	nodes_.push_back({count, node_count, 0, 0});
+	nodes_.shrink_to_fit();
+
+	for (uint32_t n = 0; n < node_count; ++n) {
+		const uint32_t first = nodes_[n].first_term;
+		if (ends[n] - first > RankedRun) {
+			ranked_.push_back(n);
+			top_.resize(top_.size() + TopStored);
+			[[maybe_unused]] const auto kept = select_top(
+			        first,
+			        ends[n],
+			        std::span(top_).last(TopStored));
+		}
+	}
+}
+
+[[nodiscard]] uint32_t Vocabulary::children_end(const uint32_t n) const
+{
+	return nodes_[n + 1].first_child;
+}
+
+[[nodiscard]] uint32_t Vocabulary::find_child(const uint32_t n,
+                                              const char c) const
+{
+	const Node& node = nodes_[n];
+	const std::span children(nodes_.data() + node.first_child,
+	                         nodes_.data() + children_end(n));
+	const auto edge_char = [&](const Node& child) {
+		return fold(term(child.first_term)[node.depth]);
+	};
+	const auto it = std::ranges::lower_bound(children, c, {}, edge_char);
+	if (it == children.end() || edge_char(*it) != c) {
+		return 0;
+	}
+	return static_cast<uint32_t>(node.first_child +
+	                             (it - children.begin()));
+}
+
+[[nodiscard]] uint32_t Vocabulary::run_end(const uint32_t parent,
+                                           const uint32_t child,
+                                           const uint32_t parent_end) const
+{
+	const uint32_t next = child + 1;
+	return (next < children_end(parent)) ? nodes_[next].first_term
+	                                     : parent_end;
+}
+
+[[nodiscard]] size_t Vocabulary::select_top(const uint32_t first,
+                                          const uint32_t end,
+                                          const std::span<uint32_t> out) const
+{
+	size_t kept = 0;
+	for (uint32_t t = first; t < end; ++t) {
+		// Earlier terms win ties, so the kept ones stay alphabetical
+		size_t pos = kept;
+		while (pos > 0 && frequency_[out[pos - 1]] < frequency_[t]) {
+			--pos;
+		}
+		if (pos == out.size()) {
+			continue;
+		}
+		kept = std::min(kept + 1, out.size());
+		std::shift_right(out.begin() + static_cast<ptrdiff_t>(pos),
+		                 out.begin() + static_cast<ptrdiff_t>(kept),
+		                 1);
+		out[pos] = t;
+	}
+	return kept;
+}
+
+[[nodiscard]] std::optional<Vocabulary::Position> Vocabulary::walk(
+        const std::string_view prefix) const
+{
+	if (nodes_.empty()) {
+		return std::nullopt;
+	}
+
+	// Each step checks the rest of a node's edge, then moves on to the
+	// child the next character picks
+	Position pos   = {0, static_cast<uint32_t>(size())};
+	size_t matched = 0;
+	while (true) {
+		const Node& node      = nodes_[pos.node];
+		const auto spelled    = term(node.first_term);
+		const size_t edge_end =
+		        std::min<size_t>(node.depth, prefix.size());
+		for (; matched < edge_end; ++matched) {
+			if (fold(spelled[matched]) != fold(prefix[matched])) {
+				return std::nullopt;
+			}
+		}
+		if (prefix.size() <= node.depth) {
+			return pos;
+		}
+		const uint32_t child = find_child(pos.node,
+		                                  fold(prefix[node.depth]));
+		if (child == 0) {
+			return std::nullopt;
+		}
+		pos = {child, run_end(pos.node, child, pos.end)};
+	}
+}
+
+[[nodiscard]] Completions Vocabulary::complete(
+        const std::string_view prefix) const
+{
+	const auto pos = prefix.empty() ? std::nullopt : walk(prefix);
+	if (!pos) {
+		return {};
+	}
+
+	const Node& node   = nodes_[pos->node];
+	Completions result = {node.first_term,
+	                      pos->end - node.first_term,
+	                      node.depth,
+	                      pos->node};
+
+	if (prefix.size() == node.depth) {
+		result.common = node.hint;
+
+		// The prefix is a term itself, which doesn't complete it
+		if (term(node.first_term).size() == prefix.size()) {
+			++result.first;
+			--result.count;
+		}
+	}
+	return result.empty() ? Completions{} : result;
+}
+
+[[nodiscard]] std::optional<uint32_t> Vocabulary::find(
+        const std::string_view word) const
+{
+	const auto pos = word.empty() ? std::nullopt : walk(word);
+	if (!pos) {
+		return std::nullopt;
+	}
+
+	// A term the node spells in full is the first of its run
+	const Node& node = nodes_[pos->node];
+	if (node.depth != word.size() ||
+	    term(node.first_term).size() != word.size()) {
+		return std::nullopt;
+	}
+	return node.first_term;
+}
+
+[[nodiscard]] std::string_view Vocabulary::term(const size_t index) const
+{
+	return std::string_view(text_).substr(
+	        offsets_[index],
+	        offsets_[index + 1] - offsets_[index]);
+}
+
+struct Vocabulary::SimilarWalk {
+	static constexpr size_t Columns = MaxSimilarLength + 1;
+	static constexpr size_t Rows    = MaxSimilarLength + MaxEdits + 1;
+
+	std::string_view word                                   = {}; // folded
+	size_t max_edits                                        = 0;
+	std::array<char, Rows> letters                          = {};
+	std::array<std::array<uint8_t, Columns>, Rows> distance = {};
+	std::vector<uint32_t>* out                              = nullptr;
+};
+
+void Vocabulary::walk_similar(const uint32_t n, const size_t from,
+                              SimilarWalk& walk) const
+{
+	const Node& node   = nodes_[n];
+	const auto spelled = term(node.first_term);
+	const auto& word   = walk.word;
+	auto& d            = walk.distance;
+
+	// Row i holds the edit distances between the first i letters of the
+	// path and each prefix of the word. Past word.size() + max_edits
+	// letters nothing can be within budget.
+	for (size_t i = from + 1; i <= node.depth; ++i) {
+		if (i >= SimilarWalk::Rows) {
+			return;
+		}
+		const char c    = fold(spelled[i - 1]);
+		walk.letters[i] = c;
+		d[i][0]         = static_cast<uint8_t>(i);
+		uint8_t best    = d[i][0];
+		for (size_t j = 1; j <= word.size(); ++j) {
+			const int cost = (c == word[j - 1]) ? 0 : 1;
+			int cell       = std::min({d[i - 1][j] + 1,
+			                           d[i][j - 1] + 1,
+			                           d[i - 1][j - 1] + cost});
+
+			// Two adjacent letters swapped
+			if (i > 1 && j > 1 && c == word[j - 2] &&
+			    walk.letters[i - 1] == word[j - 1]) {
+				cell = std::min(cell, d[i - 2][j - 2] + 1);
+			}
+			d[i][j] = static_cast<uint8_t>(cell);
+			best    = std::min(best, d[i][j]);
+		}
+		if (best > walk.max_edits) {
+			return;
+		}
+	}
+
+	if (spelled.size() == node.depth &&
+	    d[node.depth][word.size()] <= walk.max_edits) {
+		walk.out->push_back(node.first_term);
+	}
+	const uint32_t last = children_end(n);
+	for (uint32_t child = node.first_child; child < last; ++child) {
+		walk_similar(child, node.depth, walk);
+	}
+}
+
+void Vocabulary::find_similar(const std::string_view word,
+                              const size_t max_edits,
+                              std::vector<uint32_t>& out) const
+{
+	if (nodes_.empty() || word.empty() || word.size() > MaxSimilarLength) {
+		return;
+	}
+
+	std::array<char, MaxSimilarLength> folded = {};
+	std::ranges::transform(word, folded.begin(), fold);
+
+	SimilarWalk walk = {};
+	walk.word        = std::string_view(folded.data(), word.size());
+	walk.max_edits   = std::min(max_edits, MaxEdits);
+	walk.out         = &out;
+	for (size_t j = 0; j <= word.size(); ++j) {
+		walk.distance[0][j] = static_cast<uint8_t>(j);
+	}
+	walk_similar(0, 0, walk);
+}
+
+[[nodiscard]] size_t Vocabulary::top(
+        const Completions& completions,
+        const std::span<std::string_view, TopCompletions> out) const
+{
+	if (completions.empty()) {
+		return 0;
+	}
+
+	std::array<uint32_t, TopStored> picked = {};
+	size_t count                           = 0;
+
+	const uint32_t end = completions.first + completions.count;
+	const auto ranked  = std::ranges::lower_bound(ranked_,
+	                                              completions.node);
+	if (ranked != ranked_.end() && *ranked == completions.node) {
+		// The stored terms may include the prefix itself, which
+		// doesn't complete it
+		const auto slot = static_cast<size_t>(ranked - ranked_.begin());
+		for (const uint32_t t :
+		     std::span(top_).subspan(slot * TopStored, TopStored)) {
+			if (t >= completions.first && t < end) {
+				picked[count++] = t;
+			}
+		}
+	} else {
+		count = select_top(completions.first, end, picked);
+	}
+
+	count = std::min(count, out.size());
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = term(picked[i]);
+	}
+	return count;
+}
+
+[[nodiscard]] size_t Vocabulary::size() const
+{
+	return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
@@ -0,0 +1,145 @@
+#ifndef VOCABULARY_H
+#define VOCABULARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Vocabulary
+// ============================================================================
+
+// Terms that extend a prefix: a run of the sorted terms, how long a
+// prefix they all share, and the trie node the prefix led to
+struct Completions {
+	uint32_t first  = 0;
+	uint32_t count  = 0;
+	uint32_t common = 0;
+	uint32_t node   = 0;
+
+	[[nodiscard]] bool empty() const
+	{
+		return count == 0;
+	}
+};
+
+// Immutable radix trie over the keys and words of every entry, built once
+// at load. Terms are deduplicated ignoring case, sorted, and stored back
+// to back in one string; each node covers the contiguous run of terms
+// below it, so a prefix lookup walks at most one node per character and
+// the completion count and shared extension come straight from the node.
+// Nodes take 12 bytes. Nodes over runs too long to rank on demand also
+// keep their most frequent terms, so prefixes of one or two letters that
+// match thousands of words are ranked as quickly as long ones.
+class Vocabulary {
+	// A node spells the first depth characters of each of its terms.
+	// Nodes are laid out breadth first, so a node's children are stored
+	// together, ordered by their next character, and end where the next
+	// node's begin; a sentinel closes the last range. A node's run of
+	// terms likewise ends where its next sibling's begins, or where its
+	// parent's ends.
+	//
+	// hint is the length of the prefix shared by the completions of a
+	// prefix that ends exactly at the node. That is depth, unless the
+	// node spells a term in full and has one child to extend into.
+	struct Node {
+		uint32_t first_term  = 0;
+		uint32_t first_child = 0;
+		uint16_t depth       = 0;
+		uint16_t hint        = 0;
+	};
+
+	// Runs longer than this have their top terms stored at build
+	static constexpr size_t RankedRun = 64;
+
+	std::string text_                = {};
+	std::vector<uint32_t> offsets_   = {}; // term i ends where i + 1 begins
+	std::vector<uint32_t> frequency_ = {}; // occurrences of each term
+	std::vector<Node> nodes_         = {};
+	std::vector<uint32_t> ranked_    = {}; // nodes with stored top terms
+	std::vector<uint32_t> top_       = {}; // TopStored terms per ranked_
+
+	[[nodiscard]] uint32_t children_end(const uint32_t n) const;
+
+	// Index of the child of node n whose edge starts with c, or zero
+	[[nodiscard]] uint32_t find_child(const uint32_t n, const char c) const;
+
+	// Where the run of terms of child ends, given where its parent's does
+	[[nodiscard]] uint32_t run_end(const uint32_t parent,
+	                               const uint32_t child,
+	                               const uint32_t parent_end) const;
+
+	// Where a prefix leads: the node it ends at or on the edge into, and
+	// where that node's run of terms ends
+	struct Position {
+		uint32_t node = 0;
+		uint32_t end  = 0;
+	};
+
+	// nullopt if no term starts with the prefix
+	[[nodiscard]] std::optional<Position> walk(
+	        const std::string_view prefix) const;
+
+	// Edit distance rows of a find_similar() walk, one per trie depth
+	struct SimilarWalk;
+
+	// Extends the rows along the edge into node n, whose parent spells
+	// from characters, and recurses into its children while any row
+	// entry is still within the edit budget
+	void walk_similar(const uint32_t n, const size_t from,
+	                  SimilarWalk& walk) const;
+
+	// Fills out with the most frequent terms of [first, end), best first
+	// and alphabetically among equals; returns how many
+	[[nodiscard]] size_t select_top(const uint32_t first,
+	                                const uint32_t end,
+	                                const std::span<uint32_t> out) const;
+
+public:
+	Vocabulary() = default;
+
+	// Terms are ranked by how often they occur in the list. Those
+	// longer than MaxTermLength are left out.
+	explicit Vocabulary(std::vector<std::string_view> terms);
+
+	static constexpr size_t MaxTermLength  = UINT16_MAX;
+	static constexpr size_t TopCompletions = 4;
+
+	// One more than shown, as a prefix that is a term itself drops it
+	static constexpr size_t TopStored = TopCompletions + 1;
+
+	// Terms strictly longer than the lowercased prefix that start with it
+	[[nodiscard]] Completions complete(const std::string_view prefix) const;
+
+	// Index of the term, ignoring case
+	[[nodiscard]] std::optional<uint32_t> find(
+	        const std::string_view word) const;
+
+	static constexpr size_t MaxSimilarLength = 32;
+	static constexpr size_t MaxEdits         = 2;
+
+	// Appends the terms at most max_edits from word, ignoring case.
+	// Inserting, deleting or replacing a letter, or swapping two adjacent
+	// ones, is one edit. The trie is walked once, carrying a row of edit
+	// distances per letter and leaving a branch once no entry of its row
+	// is within budget; words over MaxSimilarLength match nothing.
+	void find_similar(const std::string_view word,
+	                  const size_t max_edits,
+	                  std::vector<uint32_t>& out) const;
+
+	// The most frequent completions, best first; returns how many
+	[[nodiscard]] size_t top(
+	        const Completions& completions,
+	        const std::span<std::string_view, TopCompletions> out) const;
+
+	// A term as first seen, keeping its case
+	[[nodiscard]] std::string_view term(const size_t index) const;
+
+	[[nodiscard]] size_t size() const;
+};
+
+#endif
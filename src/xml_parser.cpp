@@ -11,8 +11,7 @@
 
 #include "xml_parser.h"
 
-#include "utilities.h"
-
+#include <cstring>
 #include <iostream>
 #include <string_view>
 
@@ -20,14 +19,16 @@
 // XML Parser
 // ============================================================================
 
-[[nodiscard]] std::map<std::string, std::set<std::string>> XMLParser::parse_alternate_names(
-        const tinyxml2::XMLElement* root)
+[[nodiscard]] std::map<std::string, std::set<std::string>>
+XMLParser::parse_alternate_names(const tinyxml2::XMLElement* root)
 {
 	std::map<std::string, std::set<std::string>> names = {};
 
+	constexpr auto Tag = "AlternateName";
+
 	try {
-		for (const auto* elem = root->FirstChildElement("AlternateName"); elem;
-		     elem = elem->NextSiblingElement("AlternateName")) {
+		for (const auto* elem = root->FirstChildElement(Tag); elem;
+		     elem             = elem->NextSiblingElement(Tag)) {
 
 			const auto* id   = get_text(elem, "GameId");
 			const auto* name = get_text(elem, "Name");
@@ -42,66 +43,105 @@
 	return names;
 }
 
-[[nodiscard]] std::vector<Entry> XMLParser::parse_games(
-        const tinyxml2::XMLElement* root,
+[[nodiscard]] std::optional<Entry> XMLParser::parse_game(
+        const tinyxml2::XMLElement* game,
         const std::map<std::string, std::set<std::string>>& alt_names)
 {
-	std::vector<Entry> entries = {};
-
 	try {
-		for (const auto* game = root->FirstChildElement("Game"); game;
-		     game             = game->NextSiblingElement("Game")) {
+		const auto* key   = get_text(game, "RootFolder");
+		const auto* title = get_text(game, "Title");
 
-			try {
-				const auto* key = get_text(game, "RootFolder");
-				const auto* title = get_text(game, "Title");
+		if (!key || !title) {
+			return std::nullopt;
+		}
 
-				if (!key || !title) {
-					continue;
+		Entry entry        = {.key = key, .content = title};
+		entry.title_length = entry.content.size();
+
+		// Appends text to content as a name of the game
+		const auto add_name = [&entry](const std::string_view name) {
+			entry.content += " ";
+			entry.names.push_back(
+			        {static_cast<uint32_t>(entry.content.size()),
+			         static_cast<uint32_t>(name.size())});
+			entry.content += name;
+		};
+		entry.names.push_back(
+		        {0, static_cast<uint32_t>(entry.title_length)});
+
+		// Add alternate names
+		if (const auto* id = get_text(game, "ID")) {
+			const auto it = alt_names.find(id);
+			if (it != alt_names.end()) {
+				for (const auto& alt : it->second) {
+					add_name(alt);
 				}
+			}
+		}
 
-				Entry entry = {.key = key, .content = title};
-
-				// Add alternate names
-				if (const auto* id = get_text(game, "ID")) {
-					if (const auto it = alt_names.find(id);
-					    it != alt_names.end()) {
-						for (const auto& alt : it->second) {
-							entry.content += " " + alt;
-						}
-					}
+		// Add year if not present
+		if (const auto* date = get_text(game, "ReleaseDate")) {
+			const size_t len = std::strlen(date);
+			if (len >= 4) {
+				const std::string_view year(date, 4);
+				if (!entry.content.contains(year)) {
+					entry.content += " ";
+					entry.content += year;
 				}
+			}
+		}
 
-				// Add year if not present
-				if (const auto* date = get_text(game, "ReleaseDate")) {
-					const size_t len = std::strlen(date);
-					if (len >= 4) {
-						const std::string_view year(date, 4);
-						if (entry.content.find(year) ==
-						    std::string::npos) {
-							entry.content += " ";
-							entry.content += year;
-						}
-					}
-				}
+		// Add developer and publisher
+		const auto* dev = get_text(game, "Developer");
+		const auto* pub = get_text(game, "Publisher");
+
+		if (dev) {
+			add_name(dev);
+		}
+		if (pub && (!dev || std::string(dev) != pub)) {
+			add_name(pub);
+		}
 
-				// Add developer and publisher
-				const auto* dev = get_text(game, "Developer");
-				const auto* pub = get_text(game, "Publisher");
+		return entry;
+	} catch (...) {
+		return std::nullopt;
+	}
+}
 
-				if (dev) {
-					entry.content += " ";
-					entry.content += dev;
-				}
-				if (pub && (!dev || std::string(dev) != pub)) {
-					entry.content += " ";
-					entry.content += pub;
-				}
+[[nodiscard]] std::vector<Entry> XMLParser::parse_games(
+        const tinyxml2::XMLElement* root,
+        const std::map<std::string, std::set<std::string>>& alt_names,
+        TaskScheduler& scheduler)
+{
+	constexpr size_t GamesPerTask = 128;
+
+	std::vector<Entry> entries = {};
+
+	try {
+		std::vector<const tinyxml2::XMLElement*> games = {};
+		for (const auto* game = root->FirstChildElement("Game"); game;
+		     game             = game->NextSiblingElement("Game")) {
+			games.push_back(game);
+		}
 
-				entry.words = Util::tokenize(entry.content);
-				entries.emplace_back(std::move(entry));
-			} catch (...) {
-				continue;
+		// Each game's elements are only read by the task that owns it,
+		// as tinyxml2 decodes text lazily on first access
+		std::vector<std::optional<Entry>> parsed(games.size());
+		scheduler.parallel_for(
+		        0,
+		        games.size(),
+		        GamesPerTask,
+		        [&](const size_t begin, const size_t end) {
+			        for (size_t i = begin; i < end; ++i) {
+				        parsed[i] = parse_game(games[i],
+				                               alt_names);
+			        }
+		        });
+
+		entries.reserve(parsed.size());
+		for (auto& entry : parsed) {
+			if (entry) {
+				entries.emplace_back(std::move(*entry));
 			}
 		}
 
@@ -112,7 +152,8 @@
 	return entries;
 }
 
-[[nodiscard]] std::optional<std::vector<Entry>> XMLParser::parse(const std::string_view filename)
+[[nodiscard]] std::optional<std::vector<Entry>> XMLParser::parse(
+        const std::string_view filename, TaskScheduler& scheduler)
 {
 	try {
 		// XMLDocument's memory is cleaned up when it goes out of scope
@@ -129,7 +170,9 @@
 			return std::nullopt;
 		}
 
-		return parse_games(root, parse_alternate_names(root));
+		return parse_games(root,
+		                   parse_alternate_names(root),
+		                   scheduler);
 	} catch (const std::exception& e) {
 		std::cerr << "Error parsing XML: " << e.what() << '\n';
 		return std::nullopt;
@@ -2,6 +2,7 @@
 #define XML_PARSER_H
 
 #include "entry_t.h"
+#include "task_scheduler.h"
 
 #include <map>
 #include <optional>
@@ -19,7 +20,8 @@ class XMLElement;
 }
 
 class XMLParser {
-	static constexpr auto get_text = [](const auto* parent, const char* tag) {
+	static constexpr auto get_text = [](const auto* parent,
+	                                    const char* tag) {
 		const auto* elem = parent->FirstChildElement(tag);
 		return elem ? elem->GetText() : nullptr;
 	};
@@ -27,13 +29,18 @@ class XMLParser {
 	[[nodiscard]] static std::map<std::string, std::set<std::string>>
 	parse_alternate_names(const tinyxml2::XMLElement* root);
 
+	[[nodiscard]] static std::optional<Entry> parse_game(
+	        const tinyxml2::XMLElement* game,
+	        const std::map<std::string, std::set<std::string>>& alt_names);
+
 	[[nodiscard]] static std::vector<Entry> parse_games(
 	        const tinyxml2::XMLElement* root,
-	        const std::map<std::string, std::set<std::string>>& alt_names);
+	        const std::map<std::string, std::set<std::string>>& alt_names,
+	        TaskScheduler& scheduler);
 
 public:
 	[[nodiscard]] static std::optional<std::vector<Entry>> parse(
-	        const std::string_view filename);
+	        const std::string_view filename, TaskScheduler& scheduler);
 };
 
 #endif
@@ -0,0 +1,117 @@
+// Checks the initialism index: the spellings a name is indexed under, the
+// entries each one finds, and the pieces of a name spell() marks for an
+// acronym.
+
+#include "acronym_index.h"
+#include "check.h"
+#include "utilities.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Acronym Index Test
+// ============================================================================
+
+namespace {
+
+// An entry carrying the names, with the lowercase copy the index reads
+[[nodiscard]] Entry make_entry(
+        const std::initializer_list<std::string_view> names)
+{
+	Entry entry = {};
+	for (const auto name : names) {
+		if (!entry.content.empty()) {
+			entry.content += ' ';
+		}
+		entry.names.push_back(
+		        {static_cast<uint32_t>(entry.content.size()),
+		         static_cast<uint32_t>(name.size())});
+		entry.content += name;
+	}
+	entry.lower_content = Util::to_lower(entry.content);
+	return entry;
+}
+
+[[nodiscard]] std::vector<uint32_t> find(const AcronymIndex& index,
+                                         const std::string_view word)
+{
+	const auto found = index.find(word);
+	return {found.begin(), found.end()};
+}
+
+// The pieces spell() marks in a lowercase name, or nothing if it fails
+[[nodiscard]] std::vector<std::string_view> spell(
+        const std::string_view name, const std::string_view acronym)
+{
+	const auto words = Util::tokenize(name);
+
+	std::vector<std::string_view> pieces = {};
+	if (!AcronymIndex::spell(name, words, acronym, pieces)) {
+		check(pieces.empty(), "a failed spelling appends nothing");
+	}
+	return pieces;
+}
+
+void test_find()
+{
+	const std::vector<Entry> entries = {
+	        make_entry({"King's Quest V: Absence Makes the Heart Go "
+	                    "Yonder!",
+	                    "Sierra On-Line, Inc."}),
+	        make_entry({"Might and Magic II: Gates to Another World",
+	                    "New World Computing, Inc."}),
+	        make_entry({"Pool of Radiance (PCjr)",
+	                    "Strategic Simulations, Inc."}),
+	        make_entry({"Zork", "Strategic Simulations, Inc."}),
+	};
+	const AcronymIndex index(entries);
+	using Entries = std::vector<uint32_t>;
+
+	check(index.size() > 0, "the index is built");
+
+	check(find(index, "kq5") == Entries{0}, "numerals as digits");
+	check(find(index, "kqv") == Entries{0}, "numerals as written");
+	check(find(index, "kq") == Entries{0}, "the series without its number");
+	check(find(index, "mm2") == Entries{1}, "stop words left out");
+	check(find(index, "mam2") == Entries{1}, "stop words kept");
+	check(find(index, "ssi") == Entries{2, 3},
+	      "every entry of a company, in index order");
+	check(find(index, "por") == Entries{2}, "notes in parentheses dropped");
+
+	check(find(index, "kq5amthgy") == Entries{0}, "the full title");
+	check(find(index, "porp").empty(), "the note is not spelled");
+	check(find(index, "z").empty(), "one-word names spell nothing");
+	check(find(index, "xyz").empty(), "unknown acronyms find nothing");
+	check(AcronymIndex().find("kq").empty(), "an empty index");
+}
+
+void test_spell()
+{
+	using Pieces = std::vector<std::string_view>;
+
+	check(spell("king's quest v: absence makes the heart go yonder!",
+	            "kq5") == Pieces{"k", "q", "v"},
+	      "initials and the numeral as written");
+	check(spell("might and magic ii", "mm2") == Pieces{"m", "m", "ii"},
+	      "stop words are skipped");
+	check(spell("might and magic ii", "mam") == Pieces{"m", "a", "m"},
+	      "the series without its number");
+	check(spell("strategic simulations, inc.", "ssi") ==
+	              Pieces{"s", "s", "i"},
+	      "punctuation between words");
+	check(spell("might and magic ii", "mq").empty(),
+	      "a name that doesn't spell it");
+}
+
+} // namespace
+
+int main()
+{
+	test_find();
+	test_spell();
+	return report("acronym_index");
+}
@@ -0,0 +1,38 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// Minimal assertions for the unit tests: a failed check prints its line
+// and the test goes on, and main() returns report() as its exit status.
+
+#include <cstdlib>
+#include <iostream>
+#include <source_location>
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+inline int failures = 0;
+
+inline void check(const bool ok, const char* what,
+                  const std::source_location where =
+                          std::source_location::current())
+{
+	if (!ok) {
+		++failures;
+		std::cerr << where.file_name() << ':' << where.line()
+		          << ": FAIL: " << what << '\n';
+	}
+}
+
+[[nodiscard]] inline int report(const char* suite)
+{
+	if (failures != 0) {
+		std::cerr << suite << ": " << failures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << suite << ": PASS\n";
+	return EXIT_SUCCESS;
+}
+
+#endif
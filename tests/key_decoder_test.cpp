@@ -0,0 +1,131 @@
+// Checks the terminal key decoder: control bytes, CSI and SS3 sequences
+// with their modifiers, sequences split across reads, and how a partial
+// sequence is resolved when it times out.
+
+#include "check.h"
+#include "key_decoder.h"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Key Decoder Test
+// ============================================================================
+
+namespace {
+
+// The keys the bytes complete, in order
+[[nodiscard]] std::vector<KeyEvent> feed(KeyDecoder& decoder,
+                                         const std::string_view bytes)
+{
+	std::vector<KeyEvent> keys = {};
+	for (const char byte : bytes) {
+		if (const auto key = decoder.feed(byte)) {
+			keys.push_back(*key);
+		}
+	}
+	return keys;
+}
+
+// The one key the bytes decode to from a fresh decoder
+[[nodiscard]] std::optional<KeyEvent> decode(const std::string_view bytes)
+{
+	KeyDecoder decoder = {};
+	const auto keys    = feed(decoder, bytes);
+	if (keys.size() != 1 || decoder.pending()) {
+		return std::nullopt;
+	}
+	return keys.front();
+}
+
+[[nodiscard]] bool is(const std::optional<KeyEvent>& event, const Key key,
+                      const uint8_t modifiers = Modifier::None)
+{
+	return event && event->key == key && event->modifiers == modifiers;
+}
+
+void test_ground()
+{
+	const auto text = decode("q");
+	check(is(text, Key::Text) && text->byte == 'q', "printable text");
+	check(is(decode("\xC3"), Key::Text), "UTF-8 bytes are text");
+
+	check(is(decode("\r"), Key::Enter), "carriage return");
+	check(is(decode("\n"), Key::Enter), "line feed");
+	check(is(decode("\t"), Key::Tab), "tab");
+	check(is(decode("\x7F"), Key::Backspace), "delete byte");
+	check(is(decode("\x08"), Key::Backspace), "Ctrl+H");
+	check(is(decode("\x17"), Key::DeleteWord), "Ctrl+W");
+	check(is(decode("\x15"), Key::ClearLine), "Ctrl+U");
+	check(is(decode("\x03"), Key::Interrupt), "Ctrl+C");
+	check(is(decode("\x01"), Key::Unknown), "unmapped control byte");
+}
+
+void test_sequences()
+{
+	check(is(decode("\x1B[A"), Key::Up), "CSI arrow");
+	check(is(decode("\x1BOB"), Key::Down), "SS3 arrow");
+	check(is(decode("\x1B[H"), Key::Home), "CSI home");
+	check(is(decode("\x1B[4~"), Key::End), "numbered end");
+	check(is(decode("\x1B[5~"), Key::PageUp), "page up");
+	check(is(decode("\x1B[6~"), Key::PageDown), "page down");
+	check(is(decode("\x1B[3~"), Key::Delete), "delete");
+	check(is(decode("\x1B[Z"), Key::BackTab), "Shift+Tab");
+	check(is(decode("\x1B[200~"), Key::PasteBegin), "paste start");
+	check(is(decode("\x1B[201~"), Key::PasteEnd), "paste end");
+
+	check(is(decode("\x1B[1;5C"), Key::Right, Modifier::Ctrl),
+	      "Ctrl+Right");
+	check(is(decode("\x1B[1;2D"), Key::Left, Modifier::Shift),
+	      "Shift+Left");
+	check(is(decode("\x1B[5;3~"), Key::PageUp, Modifier::Alt),
+	      "Alt+PageUp");
+	check(is(decode("\x1B\x7F"), Key::DeleteWord, Modifier::Alt),
+	      "Alt+Backspace");
+
+	check(is(decode("\x1B[99~"), Key::Unknown), "unknown number");
+	check(is(decode("\x1B[?1;2c"), Key::Unknown),
+	      "private replies are dropped");
+}
+
+void test_split_reads()
+{
+	KeyDecoder decoder = {};
+
+	check(feed(decoder, "\x1B[1;").empty(), "a partial sequence");
+	check(decoder.pending(), "is held between reads");
+	const auto keys = feed(decoder, "5Ax");
+	check(keys.size() == 2 && is(keys[0], Key::Up, Modifier::Ctrl) &&
+	              is(keys[1], Key::Text),
+	      "and completed by the next");
+}
+
+void test_expire()
+{
+	KeyDecoder decoder = {};
+
+	check(feed(decoder, "\x1B").empty() && decoder.pending(),
+	      "a lone Esc waits");
+	check(is(decoder.expire(), Key::Escape), "and expires as Escape");
+	check(!decoder.pending(), "leaving nothing pending");
+
+	check(feed(decoder, "\x1B[1").empty(), "a partial sequence");
+	check(!decoder.expire(), "expires as nothing");
+
+	const auto keys = feed(decoder, "\x1B\x1B[A");
+	check(keys.size() == 2 && is(keys[0], Key::Escape) &&
+	              is(keys[1], Key::Up),
+	      "a second Esc makes the first a key");
+}
+
+} // namespace
+
+int main()
+{
+	test_ground();
+	test_sequences();
+	test_split_reads();
+	test_expire();
+	return report("key_decoder");
+}
@@ -0,0 +1,78 @@
+// Checks the bigram table: each term keeps its MaxSuccessors most frequent
+// followers, in id order among equals, and terms with none or out of
+// range have no row.
+
+#include "check.h"
+#include "next_words.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// Next Words Test
+// ============================================================================
+
+namespace {
+
+using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+[[nodiscard]] std::vector<uint32_t> after(const NextWords& next,
+                                          const uint32_t term)
+{
+	const auto row = next.after(term);
+	return {row.begin(), row.end()};
+}
+
+// Appends count occurrences of term followed by next
+void add(Pairs& pairs, const uint32_t term, const uint32_t next,
+         const int count)
+{
+	for (int i = 0; i < count; ++i) {
+		pairs.emplace_back(term, next);
+	}
+}
+
+void test_rows()
+{
+	Pairs pairs = {};
+	add(pairs, 0, 3, 1);
+	add(pairs, 0, 1, 4);
+	add(pairs, 0, 2, 2);
+	add(pairs, 2, 7, 1);
+	add(pairs, 2, 5, 1);
+	add(pairs, 2, 6, 3);
+	add(pairs, 2, 4, 1);
+	add(pairs, 2, 3, 1);
+
+	const NextWords next(std::move(pairs), 8);
+
+	check(after(next, 0) == std::vector<uint32_t>{1, 2, 3},
+	      "successors rank most frequent first");
+	check(after(next, 1).empty(), "a term with no successors");
+	check(after(next, 2) == std::vector<uint32_t>{6, 3, 4, 5},
+	      "ties keep id order and the row is capped");
+	check(after(next, 7).empty(), "the last term has a row");
+	check(after(next, 8).empty(), "terms past the table have none");
+}
+
+void test_empty()
+{
+	const NextWords none = {};
+	check(none.after(0).empty(), "a default table has no rows");
+
+	const NextWords unused({}, 3);
+	for (uint32_t term = 0; term < 4; ++term) {
+		check(unused.after(term).empty(),
+		      "a table without pairs has empty rows");
+	}
+}
+
+} // namespace
+
+int main()
+{
+	test_rows();
+	test_empty();
+	return report("next_words");
+}
@@ -0,0 +1,114 @@
+// Checks canonical spellings: roman numerals, words joined over
+// apostrophes, respelled names, and the synonyms a name is indexed under
+// and found back by.
+
+#include "check.h"
+#include "normalizer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Normalizer Test
+// ============================================================================
+
+namespace {
+
+constexpr std::string_view Synonyms = "# sequels\n"
+                                      "\n"
+                                      "ww2, WWII , world war 2\n"
+                                      "lotr, lord of the rings\n";
+
+[[nodiscard]] std::vector<std::string> extra_words(
+        const Normalizer& normalizer, const std::string_view name)
+{
+	std::vector<std::string> words = {};
+	normalizer.append_extra_words(name, words);
+	std::ranges::sort(words);
+	return words;
+}
+
+// The run of text find_spelling() marks for word, if any
+[[nodiscard]] std::string_view spelling(const Normalizer& normalizer,
+                                        const std::string_view word,
+                                        const std::string_view text)
+{
+	const auto words = Util::tokenize(text);
+
+	std::vector<std::string_view> found = {};
+	normalizer.find_spelling(word, text, words, found);
+	check(found.size() <= 1, "one run at most");
+	return found.empty() ? std::string_view() : found.front();
+}
+
+void test_numerals()
+{
+	check(Normalizer::roman_value("v") == 5, "a single numeral");
+	check(Normalizer::roman_value("xiv") == 14, "a subtractive pair");
+	check(Normalizer::roman_value("xxxix") == Normalizer::MaxRoman,
+	      "up to MaxRoman");
+	check(Normalizer::roman_value("xl") == 0, "past MaxRoman");
+	check(Normalizer::roman_value("iiii") == 0, "not the usual way");
+	check(Normalizer::roman_value("mix") == 0, "a word");
+
+	check(Normalizer::normalize("vii") == "7", "numerals become digits");
+	check(Normalizer::normalize("quest") == "quest", "words stay");
+}
+
+void test_respell()
+{
+	check(Normalizer::follows_apostrophe("king's quest", 5),
+	      "the s of king's");
+	check(!Normalizer::follows_apostrophe("king's quest", 7),
+	      "a word after a blank");
+
+	check(Normalizer::respell("king's quest v") == "kings quest 5",
+	      "apostrophes joined and numerals as digits");
+	check(!Normalizer::respell("space quest"), "nothing to respell");
+}
+
+void test_synonyms()
+{
+	const Normalizer normalizer(Synonyms);
+	using Words = std::vector<std::string>;
+
+	check(extra_words(normalizer, "world war ii: battles") ==
+	              Words{"2", "world war 2", "ww2", "wwii"},
+	      "respelled words and every synonym of the phrase");
+	check(extra_words(normalizer, "the lord of the rings") ==
+	              Words{"lord of the rings", "lotr"},
+	      "multi-word synonyms stay whole");
+	check(extra_words(Normalizer(), "king's quest") == Words{"kings"},
+	      "apostrophes without a synonym file");
+	check(extra_words(normalizer, "space quest").empty(),
+	      "nothing to add");
+}
+
+void test_find_spelling()
+{
+	const Normalizer normalizer(Synonyms);
+
+	check(spelling(normalizer, "7", "ultima vii") == "vii",
+	      "a numeral written as roman");
+	check(spelling(normalizer, "kings", "king's quest") == "king's",
+	      "two tokens joined over an apostrophe");
+	check(spelling(normalizer, "ww2", "world war ii: battles") ==
+	              "world war ii",
+	      "a synonym of a phrase in the text");
+	check(spelling(normalizer, "lotr", "space quest").empty(),
+	      "a text that doesn't spell it");
+}
+
+} // namespace
+
+int main()
+{
+	test_numerals();
+	test_respell();
+	test_synonyms();
+	test_find_spelling();
+	return report("normalizer");
+}
@@ -0,0 +1,289 @@
+// Checks that searching allocates nothing once the engine's buffers have
+// grown: after a warm-up, repeated cycles of typing a query, searching and
+// rendering the results must leave the global operator new untouched on
+// every thread.
+
+#include "display_manager.h"
+#include "input_handler.h"
+#include "search_engine.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+// ============================================================================
+// Allocation Counter
+// ============================================================================
+
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<size_t> allocations{0};
+
+void* allocate(const std::size_t size, const std::size_t alignment)
+{
+	if (counting.load(std::memory_order_relaxed)) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	// aligned_alloc wants a nonzero multiple of the alignment
+	const std::size_t rounded =
+	        std::max((size + alignment - 1) / alignment, std::size_t{1}) *
+	        alignment;
+	void* p = (alignment <= alignof(std::max_align_t))
+	                ? std::malloc(size ? size : 1)
+	                : std::aligned_alloc(alignment, rounded);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+} // namespace
+
+void* operator new(const std::size_t size)
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](const std::size_t size)
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+// ============================================================================
+// Search Allocation Test
+// ============================================================================
+
+namespace {
+
+// Enough entries for several scoring chunks, with titles that exercise
+// every match class: words, typos, acronyms, folder-name subsequences
+// and alternate spellings
+[[nodiscard]] std::vector<Entry> make_entries()
+{
+	constexpr std::array<const char*, 6> Titles = {
+	        "King's Quest V: Absence Makes the Heart Go Yonder!",
+	        "Might and Magic II: Gates to Another World",
+	        "Space Quest III: The Pirates of Pestulon",
+	        "Captain Comic",
+	        "World War II: Battles of the South Pacific",
+	        "Leisure Suit Larry in the Land of the Lounge Lizards",
+	};
+	constexpr std::array<const char*, 3> Companies = {
+	        "Sierra On-Line, Inc.",
+	        "Strategic Simulations, Inc.",
+	        "New World Computing, Inc.",
+	};
+	constexpr size_t Count = 3000;
+
+	std::vector<Entry> entries = {};
+	for (size_t i = 0; i < Count; ++i) {
+		Entry entry   = {};
+		entry.key     = "eXo\\eXoDOS\\!dos\\game";
+		entry.key    += std::to_string(i);
+		entry.content = Titles[i % Titles.size()];
+		entry.title_length = entry.content.size();
+		entry.names.push_back(
+		        {0, static_cast<uint32_t>(entry.title_length)});
+
+		const std::string company = Companies[i % Companies.size()];
+		entry.content += ' ';
+		entry.content += std::to_string(1980 + i % 20);
+		entry.content += ' ';
+		entry.names.push_back(
+		        {static_cast<uint32_t>(entry.content.size()),
+		         static_cast<uint32_t>(company.size())});
+		entry.content += company;
+		entries.push_back(std::move(entry));
+	}
+	return entries;
+}
+
+// Down twice, Up and Page Down
+constexpr std::string_view Moves = "\x1B[B\x1B[B\x1B[A\x1B[6~";
+
+// One cycle of the UI thread around a search: keys that retype the query
+// and move the selection are decoded and dispatched, the search runs, and
+// the frame is rendered and written out
+struct Ui {
+	SearchEngine& engine;
+	InputHandler input       = {};
+	DisplayManager display;
+	SafeQueue<Command> queue = {};
+	DisplayState state       = {};
+	std::string query        = {};
+
+	explicit Ui(SearchEngine& search_engine)
+	        : engine(search_engine),
+	          display(search_engine)
+	{
+		display.resize({24, 100});
+		display.set_synchronized(true);
+	}
+
+	// Applies the moves the keys queued; the edits are searched below
+	void dispatch()
+	{
+		int& selected = state.selected_index;
+		while (const auto command = queue.try_pop()) {
+			const auto* move = std::get_if<MoveSelection>(
+			        &*command);
+			if (move) {
+				selected = std::max(selected + move->delta, -1);
+			}
+		}
+	}
+
+	void cycle(const std::string_view typed)
+	{
+		// Ctrl+U, the query, then the moves
+		input.feed("\x15", query, engine, queue);
+		input.feed(typed, query, engine, queue);
+		input.feed(Moves, query, engine, queue);
+		dispatch();
+
+		engine.update_query(query);
+		while (!engine.results_current(query)) {
+			engine.acquire_results();
+			std::this_thread::yield();
+		}
+		const auto last = static_cast<int>(engine.result_count()) - 1;
+
+		state.scroll_offset  = 0;
+		state.selected_index = std::min(state.selected_index, last);
+		state.metrics        = display.render(state, query);
+	}
+};
+
+} // namespace
+
+int main()
+{
+	// The frames are written to stdout, so it is discarded and the
+	// outcome reported on stderr
+#ifdef _WIN32
+	constexpr const char* NullDevice = "NUL";
+#else
+	constexpr const char* NullDevice = "/dev/null";
+#endif
+	[[maybe_unused]] const auto out = std::freopen(NullDevice, "w", stdout);
+
+	std::vector<std::string> queries = {
+	        "",
+	        "quest",
+	        "kings quest 5",
+	        "qeust pirats",
+	        "ssi",
+	        "mm2",
+	        "game12",
+	        "gm12",
+	        "world war ii south",
+	        "strategic simulations",
+	        "the legend of the",
+	        "leisure suit larry in the land of the lounge lizards "
+	        "sierra on line 1987 game",
+	        "might and magic gates to another world new world computing "
+	        "space quest pirates pestulon kings quest absence heart "
+	        "yonder captain comic battles south pacific",
+	        "extraordinarilylongwordthatmatchesnothing",
+	};
+
+	// Well past the 16 KB the search arena starts with, so the search
+	// has to grow it
+	constexpr size_t OverflowLength = 32 * 1024;
+	std::string overflow            = {};
+	while (overflow.size() < OverflowLength) {
+		overflow += "qeust pirats of the 2 ";
+	}
+	queries.push_back(std::move(overflow));
+
+	constexpr size_t WarmupRounds   = 4; // fills all three snapshot slots
+	constexpr size_t MeasuredRounds = 8;
+
+	TaskScheduler scheduler;
+	SearchEngine engine(make_entries(), scheduler);
+	Ui ui(engine);
+
+	for (size_t round = 0; round < WarmupRounds; ++round) {
+		for (const auto& query : queries) {
+			ui.cycle(query);
+		}
+	}
+
+	counting.store(true);
+	for (size_t round = 0; round < MeasuredRounds; ++round) {
+		for (const auto& query : queries) {
+			ui.cycle(query);
+		}
+	}
+	counting.store(false);
+
+	const size_t count = allocations.load();
+	if (count != 0) {
+		std::cerr << "FAIL: " << count << " allocations in "
+		          << MeasuredRounds * queries.size() << " searches\n";
+		return EXIT_FAILURE;
+	}
+	std::cerr << "PASS: no allocations in "
+	          << MeasuredRounds * queries.size() << " searches\n";
+	return EXIT_SUCCESS;
+}
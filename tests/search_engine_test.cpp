@@ -0,0 +1,102 @@
+// Checks how the search engine matches abbreviations of DOS folder names:
+// the letters of a word must appear in order in the name, tighter windows
+// rank higher, and the letters taken are what gets highlighted.
+
+#include "check.h"
+#include "search_engine.h"
+#include "task_scheduler.h"
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Search Engine Test
+// ============================================================================
+
+namespace {
+
+[[nodiscard]] Entry make_entry(const std::string_view folder,
+                               const std::string_view title)
+{
+	Entry entry        = {};
+	entry.key          = "eXo\\eXoDOS\\!dos\\";
+	entry.key         += folder;
+	entry.content      = title;
+	entry.title_length = title.size();
+	entry.names.push_back({0, static_cast<uint32_t>(title.size())});
+	return entry;
+}
+
+// Blocks until the search for query is published and acquired
+void search(SearchEngine& engine, const std::string& query)
+{
+	engine.update_query(query);
+	while (!engine.results_current(query)) {
+		engine.acquire_results();
+		std::this_thread::yield();
+	}
+}
+
+// The folder names of the results, best first
+[[nodiscard]] std::vector<std::string> folders(const SearchEngine& engine)
+{
+	std::vector<std::string> out = {};
+	for (const auto& result : engine.results(0, engine.result_count())) {
+		const std::string& key = engine.get_entry(result.index).key;
+		out.push_back(key.substr(key.find_last_of('\\') + 1));
+	}
+	return out;
+}
+
+// The key letters highlighted on the result at position
+[[nodiscard]] std::string key_marks(const SearchEngine& engine,
+                                    const size_t position)
+{
+	const auto result = engine.results(position, 1);
+	if (result.empty()) {
+		return {};
+	}
+	const std::string& key = engine.get_entry(result[0].index).key;
+
+	std::string out = {};
+	for (const auto& span : engine.match_spans(position)) {
+		if (span.field == MatchField::Key) {
+			out += key.substr(span.begin, span.length);
+		}
+	}
+	return out;
+}
+
+void test_subsequence(SearchEngine& engine)
+{
+	search(engine, "cptl");
+	check(folders(engine) ==
+	              std::vector<std::string>{"captlsm", "cappitl"},
+	      "the letters in order, tightest window first");
+	check(key_marks(engine, 0) == "cptl", "the letters taken are marked");
+	check(key_marks(engine, 1) == "cptl",
+	      "letters skipped inside the window are not");
+
+	search(engine, "ltpc");
+	check(engine.result_count() == 0, "letters out of order");
+
+	search(engine, "zzz");
+	check(engine.result_count() == 0, "letters missing from every name");
+}
+
+} // namespace
+
+int main()
+{
+	TaskScheduler scheduler;
+	// The looser match comes first, so ranking has to reorder them
+	SearchEngine engine({make_entry("cappitl", "Cappitol"),
+	                     make_entry("captlsm", "Capitalism"),
+	                     make_entry("zork1", "Zork I")},
+	                    scheduler);
+
+	test_subsequence(engine);
+	return report("search_engine");
+}
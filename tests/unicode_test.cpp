@@ -0,0 +1,104 @@
+// Checks display widths and cuts: ASCII needs no stops, wide and emoji
+// code points take two columns, and fit() never splits a grapheme cluster
+// across the cut.
+
+#include "check.h"
+#include "unicode.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Unicode Test
+// ============================================================================
+
+namespace {
+
+using Unicode::ClusterStop;
+
+// Man, zero width joiner, woman: one cluster of two columns
+constexpr std::string_view Family = "\U0001F468\u200D\U0001F469";
+
+// Bytes of text that fit in columns, measuring it first
+[[nodiscard]] size_t fit(const std::string_view text, const size_t columns)
+{
+	std::vector<ClusterStop> stops = {};
+	[[maybe_unused]] const auto width = Unicode::measure(text, stops);
+	return Unicode::fit(text, stops, columns);
+}
+
+[[nodiscard]] std::vector<uint32_t> ends(const std::string_view text)
+{
+	std::vector<ClusterStop> stops = {};
+	[[maybe_unused]] const auto width = Unicode::measure(text, stops);
+
+	std::vector<uint32_t> out = {};
+	for (const auto& stop : stops) {
+		out.push_back(stop.end);
+	}
+	return out;
+}
+
+[[nodiscard]] size_t width_of(const std::string_view text)
+{
+	std::vector<ClusterStop> stops = {};
+	return Unicode::measure(text, stops);
+}
+
+void test_widths()
+{
+	check(Unicode::code_point_width(U'a') == 1, "ASCII");
+	check(Unicode::code_point_width(U'\u00E9') == 1, "accented letter");
+	check(Unicode::code_point_width(U'\u0301') == 0, "combining mark");
+	check(Unicode::code_point_width(U'\u200D') == 0, "joiner");
+	check(Unicode::code_point_width(U'\u65E5') == 2, "CJK ideograph");
+	check(Unicode::code_point_width(U'\U0001F600') == 2, "emoji");
+
+	check(width_of("Zork") == 4, "ASCII is a column a byte");
+	check(ends("Zork").empty(), "and needs no stops");
+	check(width_of("Caf\u00E9") == 4, "precomposed accent");
+	check(width_of("Cafe\u0301") == 4, "combining accent");
+	check(width_of("\u65E5\u672C") == 4, "wide ideographs");
+	check(width_of(Family) == 2,
+	      "a joined emoji sequence is one cluster");
+}
+
+void test_stops()
+{
+	using Ends = std::vector<uint32_t>;
+
+	check(ends("Caf\u00E9") == Ends{1, 2, 3, 5}, "one stop a letter");
+	check(ends("Cafe\u0301") == Ends{1, 2, 3, 6},
+	      "the mark extends the cluster of its base");
+	check(ends(Family) == Ends{11},
+	      "the joined code point extends the cluster");
+}
+
+void test_fit()
+{
+	check(fit("Zork", 2) == 2, "ASCII cuts at the column");
+	check(fit("Zork", 10) == 4, "short text fits whole");
+	check(fit("", 3) == 0, "empty text");
+
+	check(fit("Caf\u00E9", 3) == 3, "before a two-byte letter");
+	check(fit("Caf\u00E9", 4) == 5, "after it");
+	check(fit("Cafe\u0301", 4) == 6, "a mark stays with its base");
+	check(fit("Cafe\u0301", 3) == 3, "and goes with it");
+	check(fit("\u65E5\u672C", 3) == 3, "half a wide letter is left out");
+	check(fit("\u65E5\u672C", 1) == 0, "even the first");
+	check(fit(Family, 1) == 0,
+	      "an emoji sequence is not split");
+	check(fit(Family, 2) == 11,
+	      "it fits whole or not at all");
+}
+
+} // namespace
+
+int main()
+{
+	test_widths();
+	test_stops();
+	test_fit();
+	return report("unicode");
+}
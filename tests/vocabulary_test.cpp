@@ -0,0 +1,212 @@
+// Checks the completion trie: lookups ignore case, duplicates collapse to
+// the spelling first seen, a prefix yields the run of longer terms with
+// the extension they all share, the top completions are the most
+// frequent ones whether ranked on demand or stored at build, and similar
+// terms are those within the Damerau-Levenshtein budget.
+
+#include "check.h"
+#include "vocabulary.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// Vocabulary Test
+// ============================================================================
+
+namespace {
+
+[[nodiscard]] Vocabulary make_vocabulary()
+{
+	return Vocabulary({"Quest",
+	                   "quest",
+	                   "Questron",
+	                   "Quarantine",
+	                   "quest",
+	                   "King",
+	                   "Kingdom",
+	                   "Kingdoms",
+	                   "",
+	                   "Zork"});
+}
+
+// The completions of prefix, in order
+[[nodiscard]] std::vector<std::string> completions_of(
+        const Vocabulary& vocabulary, const std::string_view prefix)
+{
+	const Completions completions = vocabulary.complete(prefix);
+
+	std::vector<std::string> out = {};
+	for (uint32_t i = 0; i < completions.count; ++i) {
+		out.emplace_back(vocabulary.term(completions.first + i));
+	}
+	return out;
+}
+
+void test_lookup()
+{
+	const Vocabulary vocabulary = make_vocabulary();
+
+	check(vocabulary.size() == 7, "duplicates and empty terms dropped");
+
+	const auto quest = vocabulary.find("QUEST");
+	check(quest.has_value(), "find ignores case");
+	check(quest && vocabulary.term(*quest) == "Quest",
+	      "the first spelling seen is kept");
+
+	check(!vocabulary.find("Ques"), "a prefix is not a term");
+	check(!vocabulary.find("Questrons"), "nor is an extension");
+	check(!vocabulary.find(""), "nor the empty string");
+}
+
+void test_completion()
+{
+	const Vocabulary vocabulary = make_vocabulary();
+
+	check(completions_of(vocabulary, "q") ==
+	              std::vector<std::string>{"Quarantine",
+	                                       "Quest",
+	                                       "Questron"},
+	      "a prefix completes to its sorted run");
+	check(completions_of(vocabulary, "QUEST") ==
+	              std::vector<std::string>{"Questron"},
+	      "a term does not complete itself");
+	check(completions_of(vocabulary, "questron").empty(),
+	      "a term with no extension has no completions");
+	check(completions_of(vocabulary, "x").empty(),
+	      "an unknown prefix has no completions");
+	check(completions_of(vocabulary, "").empty(),
+	      "the empty prefix has no completions");
+
+	// Every completion of "kin" starts "king"; those of "kingd" share
+	// "kingdom"
+	check(vocabulary.complete("kin").common == 4,
+	      "common extends along a single edge");
+	check(vocabulary.complete("kingd").common == 7,
+	      "common extends to the end of the edge");
+	check(vocabulary.complete("qu").common == 2,
+	      "common stops where the run branches");
+}
+
+// The top completions of prefix, best first
+[[nodiscard]] std::vector<std::string_view> top_of(
+        const Vocabulary& vocabulary, const std::string_view prefix)
+{
+	std::array<std::string_view, Vocabulary::TopCompletions> top = {};
+	const size_t count = vocabulary.top(vocabulary.complete(prefix), top);
+	return {top.begin(), top.begin() + static_cast<ptrdiff_t>(count)};
+}
+
+void test_top_on_demand()
+{
+	const Vocabulary vocabulary = make_vocabulary();
+
+	check(top_of(vocabulary, "q") ==
+	              std::vector<std::string_view>{"Quest",
+	                                            "Quarantine",
+	                                            "Questron"},
+	      "short runs rank by frequency, then alphabetically");
+	check(top_of(vocabulary, "quest") ==
+	              std::vector<std::string_view>{"Questron"},
+	      "the prefix itself is not a completion");
+	check(top_of(vocabulary, "x").empty(), "no completions, no top");
+}
+
+void test_top_stored()
+{
+	// More terms under "a" than are ranked on demand, with the prefix
+	// itself the most frequent of all
+	std::vector<std::string> storage = {};
+	for (int i = 0; i < 100; ++i) {
+		storage.emplace_back(1, 'a');
+		storage.back() += std::to_string(100 + i);
+	}
+	std::vector<std::string_view> terms(storage.begin(), storage.end());
+	for (int i = 0; i < 10; ++i) {
+		terms.emplace_back("a");
+	}
+	for (int i = 0; i < 5; ++i) {
+		terms.emplace_back("a150");
+	}
+	for (int i = 0; i < 3; ++i) {
+		terms.emplace_back("A120");
+	}
+	const Vocabulary vocabulary(std::move(terms));
+
+	check(top_of(vocabulary, "a") ==
+	              std::vector<std::string_view>{"a150",
+	                                            "a120",
+	                                            "a100",
+	                                            "a101"},
+	      "long runs use the stored ranking, less the prefix");
+	check(top_of(vocabulary, "a1") ==
+	              std::vector<std::string_view>{"a150",
+	                                            "a120",
+	                                            "a100",
+	                                            "a101"},
+	      "a longer prefix over the same run ranks it the same");
+	check(top_of(vocabulary, "a19") ==
+	              std::vector<std::string_view>{"a190",
+	                                            "a191",
+	                                            "a192",
+	                                            "a193"},
+	      "ties rank alphabetically");
+}
+
+// The terms within max_edits of word, sorted
+[[nodiscard]] std::vector<std::string_view> similar_to(
+        const Vocabulary& vocabulary, const std::string_view word,
+        const size_t max_edits)
+{
+	std::vector<uint32_t> found = {};
+	vocabulary.find_similar(word, max_edits, found);
+
+	std::vector<std::string_view> out = {};
+	for (const uint32_t t : found) {
+		out.push_back(vocabulary.term(t));
+	}
+	std::ranges::sort(out);
+	return out;
+}
+
+void test_similar()
+{
+	const Vocabulary vocabulary(
+	        {"Quest", "Questron", "Zork", "Zorro", "King", "Kings"});
+	using Terms = std::vector<std::string_view>;
+
+	check(similar_to(vocabulary, "QUEST", 0) == Terms{"Quest"},
+	      "the word itself, ignoring case");
+	check(similar_to(vocabulary, "qeust", 1) == Terms{"Quest"},
+	      "swapping adjacent letters is one edit");
+	check(similar_to(vocabulary, "kng", 1) == Terms{"King"},
+	      "inserting a letter is one edit");
+	check(similar_to(vocabulary, "kng", 2) == Terms{"King", "Kings"},
+	      "two edits reach further");
+	check(similar_to(vocabulary, "zorx", 1) == Terms{"Zork"},
+	      "replacing a letter is one edit");
+	check(similar_to(vocabulary, "zorrko", 2) == Terms{"Zork", "Zorro"},
+	      "deleting letters is one edit each");
+	check(similar_to(vocabulary, "zo", 5) == Terms{"Zork"},
+	      "the budget is capped at MaxEdits");
+	check(similar_to(vocabulary, "x", 1).empty(), "nothing within budget");
+
+	const std::string long_word(Vocabulary::MaxSimilarLength + 1, 'q');
+	check(similar_to(vocabulary, long_word, 2).empty(),
+	      "words over MaxSimilarLength match nothing");
+}
+
+} // namespace
+
+int main()
+{
+	test_lookup();
+	test_completion();
+	test_top_on_demand();
+	test_top_stored();
+	test_similar();
+	return report("vocabulary");
+}